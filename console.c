@@ -12,50 +12,257 @@ extern "C" {
 #endif
 
 #pragma region includes
-#include <ctype.h>
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+
+#ifdef CONSOLE_DEFERRED_LOG
+#include "console_log.h"
+#endif
 #pragma endregion includes
 
 #pragma region typedef
+
+typedef enum {
+    ESCAPE_GROUND, /**< Not inside an escape sequence */
+    ESCAPE_ESC,    /**< ESC received */
+    ESCAPE_CSI,    /**< ESC '[' received, collecting parameters */
+    ESCAPE_SS3,    /**< ESC 'O' received, waiting for the final byte */
+} escape_state_t;
+
+typedef enum {
+    KEY_NONE,
+    KEY_UP,
+    KEY_DOWN,
+    KEY_RIGHT,
+    KEY_LEFT,
+    KEY_HOME,
+    KEY_END,
+    KEY_DELETE,
+    KEY_PAGE_UP,
+    KEY_PAGE_DOWN,
+    KEY_WORD_RIGHT,
+    KEY_WORD_LEFT,
+} console_key_t;
+
+typedef struct {
+    unsigned char final; /**< Final byte of the sequence */
+    uint8_t parameter;   /**< First parameter, 0 when absent */
+    uint8_t modifier;    /**< Second parameter (xterm modifier), 0 when absent */
+    console_key_t key;   /**< Decoded key */
+} escape_key_t;
+
 #pragma endregion typedef
 
 #pragma region Private Function Prototypes
 
+static void processInputChar(unsigned char c);
+static void processMachineChar(unsigned char c, unsigned char previous);
+#ifdef CONSOLE_ENABLE_FRAMES
+static bool processFrameChar(unsigned char c);
+static void processFrame(uint8_t *frame, unsigned int length);
+static unsigned int decodeCobs(uint8_t *data, unsigned int length);
+#endif
+#if defined(CONSOLE_ENABLE_FRAMES) || defined(CONSOLE_ENABLE_HISTORY_STORE)
+static uint16_t crc16(const uint8_t *data, unsigned int length);
+#endif
+#ifdef CONSOLE_ENABLE_HISTORY_STORE
+static void loadHistory(void);
+static void appendHistoryRecord(const unsigned char *line, unsigned int length);
+static void compactHistoryJournal(void);
+static bool writeHistoryRecord(const unsigned char *line, unsigned int length);
+#endif
+static void flushOutput(void);
+static void outputBytes(const char *data, size_t length);
+static void outputString(const char *text);
+static void outputEcho(unsigned char c);
+static void outputCursorMove(unsigned int distance, char direction);
+static void outputField(const char *sign, const char *text, size_t length, unsigned int width, bool leftAlign, bool zeroPad);
 static void handleBackspace(void);
 static void handleEnter(void);
-static void handleArrowKey(void);
-static void handleArrow(unsigned int *historyIndex, int direction);
+static bool handleEscapeChar(unsigned char c);
+static console_key_t lookupEscapeKey(unsigned char final);
+static void handleKey(console_key_t key);
+static void handleDelete(void);
+static void addHistory(const unsigned char *line, unsigned int length);
+static bool isLatestHistory(const unsigned char *line, unsigned int length);
+static void recallHistory(unsigned int depth, unsigned int start);
+static unsigned int historyNext(unsigned int start);
+static unsigned int historyPrevious(unsigned int end);
 static void handlePrintableChar(unsigned char c);
-static unsigned int flushCommandBuffer(unsigned int cursorPos, unsigned char *cmdBuf, unsigned char *cmdSrc, unsigned int cmdLen);
-static unsigned int increaseCommandIndex(unsigned int *cmdIdx);
-static void freeParsedArguments(char **argv);
+static void moveCursor(unsigned int position);
+static void moveCursorLeft(unsigned int distance);
+static unsigned int previousWord(unsigned int position);
+static unsigned int nextWord(unsigned int position);
+static void replaceLine(const unsigned char *line, unsigned int length);
 static void processCommand(unsigned char *cmd, unsigned int repeating);
-static void stripLeadingWhiteSpace(unsigned char *cmd);
-static void stripTrailingWhiteSpace(unsigned char *cmd);
-static int parseToArgv(char *cmd, char ***argv);
+static int parseToArgv(char *cmd, char **argv, int maxArgs);
+static int nextToken(char **cursor, char **token);
+static bool isArgumentDelimiter(char c);
 static void executeCommand(int argc, char **argv);
+static const command_t *findCommand(const char *name);
+#ifdef CONSOLE_ENABLE_FRAMES
+static const command_t *findCommandById(uint32_t id);
+#endif
+static const command_t *indexedCommand(uint32_t hash);
+static const command_t *findSubcommand(const command_t *subcommands, const char *name);
+static const command_t *resolveCommand(int argc, char **argv, int *depth);
+static void printCommandGroup(const command_t *group);
+static void executeTypedCommand(const command_t *command, int argc, char **argv);
+static bool convertArgument(const console_arg_spec_t *spec, const char *text, console_arg_t *value);
+static bool parseUnsigned(const char *text, uint32_t base, uint32_t *value);
+static void printUsage(const command_t *command);
+static bool buildCommandIndex(void);
+static bool placeIndexBucket(unsigned int bucket, unsigned int size);
+static uint32_t hashCommandName(const char *name);
+static unsigned int commandIndexSlot(uint32_t hash, uint16_t seed, unsigned int size);
 static void helpCommand(int argc, char **argv);
+static void printAvailableCommands(bool indexed);
+static const command_t *nextCommand(const command_t *command);
 
 #pragma endregion Private Function Prototypes
 
 #pragma region defines
+
+#define COMMAND_INDEX_BUCKET_LOAD 4
+#define COMMAND_INDEX_BUCKETS     ((CONSOLE_MAX_COMMANDS + COMMAND_INDEX_BUCKET_LOAD - 1) / COMMAND_INDEX_BUCKET_LOAD)
+#define COMMAND_INDEX_MAX_SEED    0xFFFF
+
+#define ESCAPE_MAX_PARAMS 2
+
+#define HISTORY_RECORD_MAGIC 0x5A
+
+/**
+ * Debug messages of the console itself go through debug_print, or into the deferred
+ * binary log of console_log.h when CONSOLE_DEFERRED_LOG is defined.
+ */
+#ifdef CONSOLE_DEFERRED_LOG
+#define CONSOLE_LOG_EMIT(...) CONSOLE_LOG_DEFERRED(__VA_ARGS__)
+#else
+#define CONSOLE_LOG_EMIT(...)                                                                                          \
+    do {                                                                                                               \
+        if (consoleIO && consoleIO->debug_print) {                                                                     \
+            consoleIO->debug_print(__VA_ARGS__);                                                                       \
+        }                                                                                                              \
+    } while (0)
+#endif
+
+/**
+ * Messages above CONSOLE_LOG_LEVEL compile to nothing; the others are filtered at run
+ * time against the level set with consoleSetLogLevel().
+ */
+#define CONSOLE_LOG_ENABLED(level) (CONSOLE_LOG_LEVEL >= (level) && consoleLogLevel >= (level))
+#define CONSOLE_LOG_AT(level, ...)                                                                                     \
+    do {                                                                                                               \
+        if (consoleLogLevel >= (level)) {                                                                              \
+            CONSOLE_LOG_EMIT(__VA_ARGS__);                                                                             \
+        }                                                                                                              \
+    } while (0)
+
+#if CONSOLE_LOG_LEVEL >= CONSOLE_LOG_LEVEL_ERROR
+#define CONSOLE_LOG_ERROR(...) CONSOLE_LOG_AT(CONSOLE_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define CONSOLE_LOG_ERROR(...) ((void)0)
+#endif
+#if CONSOLE_LOG_LEVEL >= CONSOLE_LOG_LEVEL_WARN
+#define CONSOLE_LOG_WARN(...) CONSOLE_LOG_AT(CONSOLE_LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define CONSOLE_LOG_WARN(...) ((void)0)
+#endif
+#if CONSOLE_LOG_LEVEL >= CONSOLE_LOG_LEVEL_INFO
+#define CONSOLE_LOG_INFO(...) CONSOLE_LOG_AT(CONSOLE_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define CONSOLE_LOG_INFO(...) ((void)0)
+#endif
+#if CONSOLE_LOG_LEVEL >= CONSOLE_LOG_LEVEL_TRACE
+#define CONSOLE_LOG_TRACE(...) CONSOLE_LOG_AT(CONSOLE_LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+#define CONSOLE_LOG_TRACE(...) ((void)0)
+#endif
+
+#ifdef CONSOLE_SECTION_COMMANDS
+#define SECTION_COMMANDS_START (&__start_console_commands[0])
+#define SECTION_COMMANDS_STOP  (&__stop_console_commands[0])
+#else
+#define SECTION_COMMANDS_START ((const command_t *)NULL)
+#define SECTION_COMMANDS_STOP  ((const command_t *)NULL)
+#endif
+
 #pragma endregion defines
 
 #pragma region variables
 
+#ifdef CONSOLE_SECTION_COMMANDS
+// Provided by the linker; weak so that an image without CONSOLE_COMMAND() still links
+extern const command_t __start_console_commands[] __attribute__((weak));
+extern const command_t __stop_console_commands[] __attribute__((weak));
+#endif
+
+static command_t helpCmd      = {"help", helpCommand, NULL, NULL, NULL};
 static command_t *commandList = NULL;
 static unsigned char consoleInputBuffer[CONSOLE_BUFFER_SIZE];
 static unsigned int inputPosition = 0;
-static unsigned char commandHistory[CONSOLE_HISTORY_LENGTH][CONSOLE_BUFFER_SIZE];
-static unsigned int historyPosition[CONSOLE_HISTORY_LENGTH];
-static unsigned int historyInsert;
-static unsigned int historyOutput;
-static unsigned int historyInsertWrap;
-static unsigned int historyOutputWrap;
-static unsigned int upArrowCount;
+static unsigned char historyRing[CONSOLE_HISTORY_SIZE];
+static unsigned int historyTail;    // Start of the oldest entry
+static unsigned int historyHead;    // End of the newest entry
+static unsigned int historyUsed;    // Bytes used by all entries, including their tags
+static unsigned int historyCount;   // Number of entries
+static unsigned int historyDepth;   // Entry on the input line: 0 none, 1 newest
+static unsigned int historyBrowse;  // Start of the entry on the input line
+#ifdef CONSOLE_ENABLE_HISTORY_STORE
+static const console_history_store_t *historyStore;
+static uint32_t journalOffset;  // End of the last valid journal record
+static bool journalDirty;       // The journal must be rewritten before the next append
+#endif
+static unsigned int pendingEcho;
+static char consoleOutput[CONSOLE_OUTPUT_SIZE + 1];
+static size_t outputLength;
+static bool inputPass;
+static unsigned char lastInputChar;
+static unsigned int cursorPosition;
+static escape_state_t escapeState;
+static uint8_t escapeParams[ESCAPE_MAX_PARAMS];
+static unsigned int escapeParamCount;
+static bool machineMode;
+static bool lineOverflow;
+#ifdef CONSOLE_ENABLE_FRAMES
+static uint8_t consoleFrameBuffer[CONSOLE_FRAME_SIZE];
+static unsigned int frameLength;
+static bool frameActive;
+static bool frameSynced;
+static bool frameDiscard;  // Dropping the rest of an oversized frame
+#endif
+static char *consoleArgv[CONSOLE_MAX_ARGS + 1];
+static console_arg_t consoleTypedArgs[CONSOLE_MAX_ARGS];
 static const console_io_t *consoleIO;
+static uint8_t consoleLogLevel = CONSOLE_LOG_LEVEL;
+
+// CSI and SS3 sequences sent by VT100, xterm and rxvt style terminals
+static const escape_key_t escapeKeys[] = {
+    {'A', 0, 0, KEY_UP},
+    {'B', 0, 0, KEY_DOWN},
+    {'C', 0, 0, KEY_RIGHT},
+    {'D', 0, 0, KEY_LEFT},
+    {'H', 0, 0, KEY_HOME},
+    {'F', 0, 0, KEY_END},
+    {'~', 1, 0, KEY_HOME},
+    {'~', 7, 0, KEY_HOME},
+    {'~', 4, 0, KEY_END},
+    {'~', 8, 0, KEY_END},
+    {'~', 3, 0, KEY_DELETE},
+    {'~', 5, 0, KEY_PAGE_UP},
+    {'~', 6, 0, KEY_PAGE_DOWN},
+    {'C', 1, 5, KEY_WORD_RIGHT},  // Ctrl-Right
+    {'D', 1, 5, KEY_WORD_LEFT},   // Ctrl-Left
+    {'C', 1, 3, KEY_WORD_RIGHT},  // Alt-Right
+    {'D', 1, 3, KEY_WORD_LEFT},   // Alt-Left
+};
+
+static const command_t *indexSlots[CONSOLE_MAX_COMMANDS];
+static uint16_t indexSeeds[COMMAND_INDEX_BUCKETS];
+static const command_t *indexKeys[CONSOLE_MAX_COMMANDS];     // Build scratch: commands sorted by bucket
+static uint16_t indexBucketStart[COMMAND_INDEX_BUCKETS + 1];  // Build scratch: first key of each bucket
+static command_index_t ramIndex            = {NULL, indexSlots, indexSeeds, 0, 0};
+static const command_index_t *commandIndex = &ramIndex;
 
 #pragma endregion variables
 
@@ -66,14 +273,21 @@ static const console_io_t *consoleIO;
  *
  * This function initializes the console by setting up the command list and I/O handlers.
  * It first adds a built-in "help" command, then adds all user-defined commands from the
- * provided command array. The commands are stored in a linked list structure.
+ * provided command array. The commands are stored in a linked list structure, and a
+ * perfect-hash index is built over their names so that dispatch does not depend on
+ * the number of registered commands.
  *
  * @param io Pointer to console_io_t structure containing I/O function handlers
  * @param commands Pointer to array of command_t structures defining available commands.
  *                 The array must be NULL-terminated (last command's name must be NULL)
  *
  * @note This function dynamically allocates memory for each command. If allocation fails,
- *       the function will return early and print a debug message if debug_print is available.
+ *       the remaining commands are skipped and a debug message is printed if debug_print
+ *       is available; the commands copied so far stay usable. Use consoleInitInPlace()
+ *       for a configuration without heap.
+ *
+ * @note If the index cannot be built (more than CONSOLE_MAX_COMMANDS commands), lookup
+ *       falls back to walking the command list.
  *
  * @note After initialization, if debug printing is enabled, the function will print
  *       a list of all available commands.
@@ -82,19 +296,17 @@ void consoleInit(const console_io_t *io, const command_t *commands) {
     const command_t *cmdPtr = commands;
 
     // Add help command first
-    static command_t helpCmd = {"help", helpCommand, NULL};
-    helpCmd.next             = NULL;
-    commandList              = &helpCmd;
-    command_t *lastCmd       = commandList;
+    helpCmd.next       = NULL;
+    commandList        = &helpCmd;
+    command_t *lastCmd = commandList;
+    consoleIO          = io;
 
     // Add remaining commands in original order
     while (cmdPtr && cmdPtr->command != NULL) {
         command_t *cmdCopy = (command_t *)malloc(sizeof(command_t));
         if (cmdCopy == NULL) {
-            if (consoleIO && consoleIO->debug_print) {
-                consoleIO->debug_print("Failed to allocate memory for command\r\n");
-            }
-            return;
+            CONSOLE_LOG_ERROR("Failed to allocate memory for command\r\n");
+            break;
         }
         memcpy(cmdCopy, cmdPtr, sizeof(command_t));
         cmdCopy->next = NULL;
@@ -106,18 +318,75 @@ void consoleInit(const console_io_t *io, const command_t *commands) {
         cmdPtr++;
     }
 
-    consoleIO = io;
+    printAvailableCommands(buildCommandIndex());
+#ifdef CONSOLE_ENABLE_HISTORY_STORE
+    loadHistory();
+#endif
+}
 
-    // Debug print available commands
-    if (io && io->debug_print) {
-        io->debug_print("Available commands:\r\n");
-        command_t *curr = commandList;
-        while (curr) {
-            io->debug_print("  %s\r\n", curr->command);
-            curr = curr->next;
-        }
-        io->debug_print("\r\n");
+/**
+ * @brief Initializes the console without any heap allocation
+ *
+ * Links the caller's own command_t nodes in place through their `next` field instead
+ * of copying them, so initialization is deterministic and cannot fail part way. The
+ * perfect-hash index is built in static storage, exactly as with consoleInit().
+ *
+ * Example:
+ * @code
+ * static command_t commands[] = {
+ *     {"hello", helloCommand, NULL},
+ *     {NULL, NULL, NULL}  // End of commands
+ * };
+ *
+ * consoleInitInPlace(&std_io, commands);
+ * @endcode
+ *
+ * @param io Pointer to console_io_t structure containing I/O function handlers
+ * @param commands Writable, NULL-terminated array of commands. The console keeps
+ *                 pointers to its elements, so it must outlive the console (typically
+ *                 static storage), and their `next` fields are overwritten.
+ */
+void consoleInitInPlace(const console_io_t *io, command_t *commands) {
+    command_t *lastCmd = &helpCmd;
+
+    commandList = &helpCmd;
+    consoleIO   = io;
+
+    while (commands && commands->command != NULL) {
+        lastCmd->next = commands;
+        lastCmd       = commands;
+        commands++;
     }
+    lastCmd->next = NULL;
+
+    printAvailableCommands(buildCommandIndex());
+#ifdef CONSOLE_ENABLE_HISTORY_STORE
+    loadHistory();
+#endif
+}
+
+/**
+ * @brief Initializes the console with a prebuilt command index
+ *
+ * Unlike consoleInit(), this function neither copies nor hashes anything: the index,
+ * typically generated at compile time by console.hpp and placed in read-only memory,
+ * is used as is. Only the built-in "help" command is linked into the command list.
+ * Commands registered with CONSOLE_COMMAND() are not part of a prebuilt index; they are
+ * found by the linear fallback of the lookup.
+ *
+ * @param io Pointer to console_io_t structure containing I/O function handlers
+ * @param index Pointer to the command index. It must stay valid while the console is in use.
+ */
+void consoleInitIndex(const console_io_t *io, const command_index_t *index) {
+    helpCmd.next = NULL;
+    commandList  = &helpCmd;
+    commandIndex = index;
+    consoleIO    = io;
+
+    printAvailableCommands(true);
+#ifdef CONSOLE_ENABLE_HISTORY_STORE
+    loadHistory();
+#endif
 }
 
 /**
@@ -126,316 +395,1841 @@ void consoleInit(const console_io_t *io, const command_t *commands) {
  * Processes individual characters received from the console input.
  * Handles special characters including:
  * - Backspace ('\b' or DEL)
- * - Enter ('\r')
- * - Arrow keys (starting with '[')
- * - Printable characters
+ * - Enter ('\r', '\n' or "\r\n")
+ * - VT100/ANSI escape sequences: Up/Down browse the history, PgUp/PgDn jump to its
+ *   oldest/newest entry, Left/Right, Home/End and Ctrl-Left/Ctrl-Right move the
+ *   cursor, Delete removes the character under it
+ * - Printable characters, inserted at the cursor
  *
  * The function reads a single character from consoleIO interface
  * and routes it to appropriate handler functions based on the
- * character received.
+ * character received. If getchar reports that no character is
+ * pending (a negative value such as CONSOLE_NO_DATA), the function
+ * returns immediately without touching the line editor.
+ *
+ * In machine mode (see consoleSetMachineMode()) the character is only
+ * framed into a line, without echo, editing or history.
+ *
+ * @return true if a character was processed, false if no input was pending
  */
-void consoleHandler(void) {
-    unsigned char c;
-    c = consoleIO->getchar();
-    switch (c) {
-        case '\b':
-        case '\x7f':  // backspace
-            handleBackspace();
-            break;
-        case '\r':  // enter
-            handleEnter();
-            break;
-        case '[':  // arrow key
-            handleArrowKey();
-            break;
-        default:
-            handlePrintableChar(c);
-            break;
-    }
-}
-
-#pragma endregion External Functions
-
-#pragma region Private Functions
-
-static void handleBackspace(void) {
-    if (inputPosition > 0) {
-        consoleIO->print("\b \b");
-        inputPosition--;
+bool consoleHandler(void) {
+    int c = consoleIO->getchar();
+    if (c < 0) {
+        return false;
     }
-    consoleInputBuffer[inputPosition] = '\0';
+    inputPass = true;
+    processInputChar((unsigned char)c);
+    inputPass = false;
+    flushOutput();
+    return true;
 }
 
-static void handleEnter(void) {
-    consoleIO->print("\r\n");
-    if (inputPosition) {
-        if (strcmp((const char *)consoleInputBuffer, (const char *)commandHistory[historyInsert])) {
-            if (increaseCommandIndex(&historyInsert) == 1) {
-                historyInsertWrap = 1;
-            }
-            memcpy(commandHistory[historyInsert], consoleInputBuffer, CONSOLE_BUFFER_SIZE);
-            historyPosition[historyInsert] = inputPosition;
-        }
-        historyOutput     = historyInsert;
-        historyOutputWrap = 0;
-        upArrowCount      = 0;
-        processCommand(consoleInputBuffer, 0);
-        inputPosition = 0;
-        memset(consoleInputBuffer, 0, CONSOLE_BUFFER_SIZE);
-        consoleIO->print("\r\n");
-    }
-    consoleIO->print("> ");
-}
+/**
+ * @brief Processes pending console input within a budget
+ *
+ * Reads and processes characters until getchar reports that no more input is pending,
+ * maxBytes characters have been processed, or maxTicks ticks of consoleIO->ticks have
+ * elapsed, whichever comes first. This lets a main loop drain an input burst in one
+ * call while bounding how long it stays away from its real-time work. The echo of all
+ * processed characters is coalesced.
+ *
+ * The budget is checked between characters, so a command dispatched by the last
+ * character may still overrun the deadline.
+ *
+ * @param maxBytes Maximum number of characters to process, 0 for no limit
+ * @param maxTicks Maximum number of ticks to spend, 0 for no limit. Ignored if
+ *                 consoleIO->ticks is NULL.
+ * @return Number of characters still pending according to consoleIO->available. Without
+ *         an available function, 1 if the budget ran out before the input did (more
+ *         input may be pending), 0 otherwise.
+ */
+unsigned int consoleHandlerBudget(unsigned int maxBytes, uint32_t maxTicks) {
+    bool timed         = (maxTicks > 0) && (consoleIO->ticks != NULL);
+    uint32_t start     = timed ? consoleIO->ticks() : 0;
+    unsigned int count = 0;
+    bool drained       = false;
 
-static void handleArrowKey(void) {
-    unsigned char c = consoleIO->getchar();
-    switch (c) {
-        case 'A':  // up arrow
-            handleArrow(&historyOutput, -1);
-            break;
-        case 'B':  // down arrow
-            handleArrow(&historyOutput, 1);
-            break;
-        case 'C':  // right arrow
+    inputPass = true;
+    while (!drained) {
+        if ((maxBytes > 0 && count >= maxBytes) || (timed && (uint32_t)(consoleIO->ticks() - start) >= maxTicks)) {
             break;
-        case 'D':  // left arrow
-            break;
-        default:
-            break;
-    }
-}
-
-static void handleArrow(unsigned int *historyIndex, int direction) {
-    if (direction == -1) {  // up arrow
-        if (historyOutputWrap == 1 && *historyIndex == historyInsert) {
-            return;
-        }
-        if (historyInsertWrap == 0 && *historyIndex == 0) {
-            return;
-        }
-        upArrowCount++;
-    } else if (direction == 1) {  // down arrow
-        if (upArrowCount <= 1) {
-            return;
         }
-        upArrowCount--;
-    }
-
-    flushCommandBuffer(inputPosition, consoleInputBuffer, commandHistory[*historyIndex], historyPosition[*historyIndex]);
-    inputPosition                         = historyPosition[*historyIndex];
-    consoleInputBuffer[inputPosition + 1] = '\0';
-    consoleIO->print("%s", consoleInputBuffer);
-
-    if (direction == -1) {
-        if (historyInsertWrap == 1) {
-            if (*historyIndex == 0) {
-                *historyIndex     = CONSOLE_HISTORY_LENGTH - 1;
-                historyOutputWrap = 1;
-            } else {
-                (*historyIndex)--;
-            }
+        int c = consoleIO->getchar();
+        if (c < 0) {
+            drained = true;
         } else {
-            if (*historyIndex != 0) {
-                (*historyIndex)--;
-            }
+            processInputChar((unsigned char)c);
+            count++;
         }
-    } else if (direction == 1) {
-        increaseCommandIndex(historyIndex);
     }
-}
+    inputPass = false;
+    flushOutput();
 
-static void handlePrintableChar(unsigned char c) {
-    if (inputPosition < (CONSOLE_BUFFER_SIZE - 1) && (c >= ' ' && c <= 'z')) {
-        consoleInputBuffer[inputPosition++] = c;
-        consoleInputBuffer[inputPosition]   = '\0';
-        consoleIO->print("%s", consoleInputBuffer + inputPosition - 1);
-    }
-    if (c == '\x7e') {
-        consoleInputBuffer[inputPosition++] = c;
-        consoleInputBuffer[inputPosition]   = '\0';
-        consoleIO->print("%s", consoleInputBuffer + inputPosition - 1);
+    if (consoleIO->available != NULL) {
+        int pending = consoleIO->available();
+        return (pending > 0) ? (unsigned int)pending : 0;
     }
+    return drained ? 0 : 1;
 }
 
-static unsigned int flushCommandBuffer(unsigned int cursorPos, unsigned char *cmdBuf, unsigned char *cmdSrc, unsigned int cmdLen) {
-    if (cursorPos > 0) {
-        for (; cursorPos > 0; cursorPos--) {
-            consoleIO->print("\b \b");
-            consoleInputBuffer[cursorPos] = '\0';
-        }
+/**
+ * @brief Tells whether console input is pending
+ *
+ * Lets a polling main loop sleep instead of calling consoleHandler() while there is
+ * nothing to process. Without a console_io_t::available function the platform cannot
+ * tell, and the function conservatively reports pending input.
+ *
+ * @return true if consoleHandler() may have input to process
+ */
+bool consoleInputAvailable(void) {
+    if (consoleIO->available == NULL) {
+        return true;
     }
-    memcpy(cmdBuf, cmdSrc, cmdLen);
-    return 0;
+    return consoleIO->available() > 0;
 }
 
-static unsigned int increaseCommandIndex(unsigned int *cmdIdx) {
-    unsigned int localIdx;
-    unsigned int ret = 0;
+/**
+ * @brief Processes a block of console input in one call
+ *
+ * Equivalent to calling consoleHandler() once per byte, without going through
+ * consoleIO->getchar for every byte: suited to DMA-filled receive buffers and pasted
+ * scripts. Every complete line in the block is dispatched, a partial line at the end
+ * is kept for the next call, and the echo of consecutive printable characters is
+ * coalesced into a single print.
+ *
+ * @param buf Received bytes
+ * @param len Number of bytes in buf
+ */
+void consoleFeed(const void *buf, size_t len) {
+    const unsigned char *bytes = (const unsigned char *)buf;
 
-    localIdx = *cmdIdx;
-    localIdx++;
-    if (localIdx == CONSOLE_HISTORY_LENGTH) {
-        localIdx = 0;
-        ret      = 1;
+    inputPass = true;
+    for (size_t idx = 0; idx < len; idx++) {
+        processInputChar(bytes[idx]);
     }
-    *cmdIdx = localIdx;
-    return ret;
+    inputPass = false;
+    flushOutput();
 }
 
-static void freeParsedArguments(char **argv) {
-    if (argv) {
-        free(argv);
-    }
+/**
+ * @brief Switches between interactive and machine mode
+ *
+ * Interactive mode (the default) echoes input, supports line editing and history and
+ * prints a prompt. Machine mode is meant for automation clients driving the console at
+ * full link speed: received lines are framed on '\r', '\n' or "\r\n" and dispatched
+ * directly, with no echo, no history and no prompt, so the only output is what the
+ * commands print themselves.
+ *
+ * The function may be called from a command handler, e.g. to let the host switch
+ * modes; the new mode applies from the next line. Any partially entered line is
+ * discarded.
+ *
+ * @param enabled true to enter machine mode, false to return to interactive mode
+ */
+void consoleSetMachineMode(bool enabled) {
+    machineMode    = enabled;
+    lineOverflow   = false;
+    escapeState    = ESCAPE_GROUND;
+    pendingEcho    = 0;
+    inputPosition  = 0;
+    cursorPosition = 0;
 }
 
-static void processCommand(unsigned char *cmd, unsigned int repeating) {
-    (void)repeating;
+#ifdef CONSOLE_ENABLE_HISTORY_STORE
+/**
+ * @brief Makes the command history persistent
+ *
+ * Every new history entry is appended to a journal in the given store, and the console
+ * init functions reload the history from it. Call this function before consoleInit(),
+ * consoleInitInPlace() or consoleInitIndex(). If it is called later, the history in
+ * RAM is kept and the journal is rewritten from it on the next new entry, as the
+ * store's contents are unknown.
+ *
+ * The journal is a sequence of records (0x5A, length, line, CRC-16 of length and line)
+ * written strictly in order into erased space, so a flash store wears evenly. It is
+ * erased and rewritten from the history in RAM only when it is full or a damaged
+ * record was found, e.g. after a reset during a write. Reloading reads the records
+ * once from start to end and stops at the first erased or damaged one.
+ *
+ * @param store Journal storage callbacks, NULL to disable persistence. The structure
+ *              must stay valid while the console is in use.
+ */
+void consoleSetHistoryStore(const console_history_store_t *store) {
+    historyStore  = store;
+    journalOffset = 0;
+    journalDirty  = true;  // Never write into a journal that has not been loaded
+}
+#endif
+
+/**
+ * @brief Sets the level of the console's own debug messages at run time
+ *
+ * Messages up to the given level are emitted, the others are suppressed. Levels above
+ * CONSOLE_LOG_LEVEL are compiled out and cannot be enabled at run time.
+ *
+ * @param level One of the CONSOLE_LOG_LEVEL_* values
+ */
+void consoleSetLogLevel(uint8_t level) {
+    consoleLogLevel = level;
+}
 
-    stripLeadingWhiteSpace(cmd);
-    stripTrailingWhiteSpace(cmd);
+/**
+ * @brief Formats text into the console output
+ *
+ * A small printf replacement that needs neither vsnprintf nor floating point support
+ * and writes straight into the console output buffer, so that it is sent together with
+ * the echo and prompt. Supported conversions are %s, %c, %d, %i, %u, %x, %X and %%, with
+ * the flags '-' and '0', a field width, a precision for %s (either may be '*'), and
+ * the length modifiers 'l' and 'z'.
+ *
+ * Output produced while the console processes input, e.g. by a command, is sent at the
+ * end of the consoleHandler() pass; output produced elsewhere is sent before the
+ * function returns.
+ *
+ * @param format Format string
+ *
+ * @note The output goes through consoleIO->write, or through consoleIO->print if there
+ *       is no write function; in that case print must not itself call consolePrintf().
+ */
+void consolePrintf(const char *format, ...) {
+    va_list args;
 
-    int argc    = 0;
-    char **argv = NULL;
+    va_start(args, format);
+    consoleVprintf(format, args);
+    va_end(args);
+}
 
-    argc = parseToArgv((char *)cmd, &argv);
+/**
+ * @brief Variant of consolePrintf() taking a va_list
+ *
+ * @param format Format string
+ * @param args Arguments for the conversions in format
+ */
+void consoleVprintf(const char *format, va_list args) {
+    char digits[3 * sizeof(unsigned long)];
 
-    unsigned int idx = 0;
-    while (cmd[idx] != '\0') {
-        if (cmd[idx] == ' ' || cmd[idx] == '\t' || cmd[idx] == '\r' || cmd[idx] == '\n') {
-            cmd[idx] = '\0';
+    while (*format) {
+        const char *literal = format;
+        while (*format && *format != '%') {
+            format++;
+        }
+        outputBytes(literal, (size_t)(format - literal));
+        if (*format == '\0') {
             break;
         }
-        idx++;
-    }
+        format++;
 
-    if (argc > 0) {
-        executeCommand(argc, argv);
-    } else {
-        if (consoleIO && consoleIO->debug_print) {
-            consoleIO->debug_print("command `%s' not found, try `all help'\r\n", (argc == 0) ? "" : argv[0]);
+        bool leftAlign        = false;
+        bool zeroPad          = false;
+        unsigned int width    = 0;
+        int precision         = -1;
+        char size             = '\0';
+        unsigned long value   = 0;
+        unsigned int base     = 10;
+        const char *sign      = "";
+        const char *hexDigits = "0123456789abcdef";
+        size_t length         = 0;
+        char *text            = digits + sizeof(digits);
+
+        for (;; format++) {
+            if (*format == '-') {
+                leftAlign = true;
+            } else if (*format == '0') {
+                zeroPad = true;
+            } else {
+                break;
+            }
+        }
+        if (*format == '*') {
+            int arg = va_arg(args, int);
+            leftAlign |= (arg < 0);
+            width = (arg < 0) ? 0u - (unsigned int)arg : (unsigned int)arg;
+            format++;
+        }
+        while (*format >= '0' && *format <= '9') {
+            width = width * 10 + (unsigned int)(*format++ - '0');
+        }
+        if (*format == '.') {
+            format++;
+            precision = 0;
+            if (*format == '*') {
+                precision = va_arg(args, int);
+                format++;
+            }
+            while (*format >= '0' && *format <= '9') {
+                precision = precision * 10 + (*format++ - '0');
+            }
+        }
+        if (*format == 'l' || *format == 'z') {
+            size = *format++;
         }
-    }
 
-    if (argv != NULL) {
-        freeParsedArguments(argv);
-        argv = NULL;
+        switch (*format) {
+            case 's': {
+                const char *string = va_arg(args, const char *);
+                if (string == NULL) {
+                    string = "(null)";
+                }
+                while ((precision < 0 || length < (size_t)precision) && string[length]) {
+                    length++;
+                }
+                outputField("", string, length, width, leftAlign, false);
+                break;
+            }
+            case 'c':
+                digits[0] = (char)va_arg(args, int);
+                outputField("", digits, 1, width, leftAlign, false);
+                break;
+            case 'd':
+            case 'i': {
+                long number = (size == 'l') ? va_arg(args, long) : (size == 'z') ? (long)va_arg(args, size_t) : va_arg(args, int);
+                if (number < 0) {
+                    sign  = "-";
+                    value = 0ul - (unsigned long)number;
+                } else {
+                    value = (unsigned long)number;
+                }
+                break;
+            }
+            case 'X':
+                hexDigits = "0123456789ABCDEF";
+                // fall through
+            case 'x':
+                base = 16;
+                // fall through
+            case 'u':
+                value = (size == 'l') ? va_arg(args, unsigned long) : (size == 'z') ? (unsigned long)va_arg(args, size_t) : va_arg(args, unsigned int);
+                break;
+            case '%':
+                outputBytes("%", 1);
+                break;
+            default:  // unknown conversion, printed as is
+                outputBytes(format - 1, (*format) ? 2 : 1);
+                break;
+        }
+        switch (*format) {
+            case 'd':
+            case 'i':
+            case 'u':
+            case 'x':
+            case 'X':
+                do {
+                    *--text = hexDigits[value % base];
+                    value /= base;
+                } while (value > 0);
+                outputField(sign, text, (size_t)(digits + sizeof(digits) - text), width, leftAlign, zeroPad);
+                break;
+            default:
+                break;
+        }
+        if (*format) {
+            format++;
+        }
+    }
+    if (!inputPass) {
+        // Called outside of input processing, e.g. from the main loop: send right away
+        flushOutput();
     }
 }
 
-static void stripLeadingWhiteSpace(unsigned char *cmd) {
-    unsigned int idx  = 0;
-    unsigned int copy = 0;
+#pragma endregion External Functions
 
-    while (cmd[idx] != '\0') {
-        if (!isspace(cmd[idx])) {
-            break;
-        }
-        idx++;
-    }
+#pragma region Private Functions
 
-    if (idx > 0) {
-        while (cmd[idx] != '\0') {
-            cmd[copy++] = cmd[idx++];
-        }
-        cmd[copy] = '\0';
+/**
+ * @brief Routes one input character to its handler.
+ *
+ * Escape sequences are decoded one byte at a time by handleEscapeChar(), so a key
+ * sequence may be split across consoleHandler() calls or consoleFeed() blocks. A byte
+ * that cannot continue the pending sequence ends it and is then processed as ordinary
+ * input.
+ */
+static void processInputChar(unsigned char c) {
+    unsigned char previous = lastInputChar;
+
+#ifdef CONSOLE_ENABLE_FRAMES
+    if ((c == '\0' || frameActive) && processFrameChar(c)) {
+        return;
+    }
+#endif
+    lastInputChar = c;
+    if (machineMode) {
+        processMachineChar(c, previous);
+        return;
+    }
+    if (escapeState != ESCAPE_GROUND && handleEscapeChar(c)) {
+        return;
     }
-}
 
-static void stripTrailingWhiteSpace(unsigned char *cmd) {
-    unsigned int idx = strlen((const char *)cmd);
-    while (idx > 0) {
-        idx--;
-        if (isspace(cmd[idx])) {
-            cmd[idx] = '\0';
-        } else {
+    switch (c) {
+        case '\b':
+        case '\x7f':  // backspace
+            handleBackspace();
+            break;
+        case '\n':  // enter, unless it completes a "\r\n" line ending
+            if (previous == '\r') {
+                break;
+            }
+            handleEnter();
+            break;
+        case '\r':  // enter
+            handleEnter();
+            break;
+        case '\x1b':  // start of an escape sequence
+            escapeState = ESCAPE_ESC;
+            break;
+        default:
+            handlePrintableChar(c);
             break;
-        }
     }
 }
 
-static int parseToArgv(char *cmd, char ***argv) {
-    int argc     = 0;
-    int max_args = 10;
-    *argv        = (char **)malloc(max_args * sizeof(char *));
-    if (*argv == NULL) {
-        if (consoleIO && consoleIO->debug_print) {
-            consoleIO->debug_print("Failed to allocate memory for argv\r\n");
+/**
+ * @brief Frames one input character in machine mode.
+ *
+ * Bytes are stored as they are received, without echo, editing or escape sequence
+ * decoding. A line terminator dispatches the line directly, bypassing the history and
+ * the prompt; empty lines are ignored. A line longer than the input buffer is
+ * discarded as a whole when its terminator arrives, so a truncated command is never
+ * executed.
+ */
+static void processMachineChar(unsigned char c, unsigned char previous) {
+    if (c == '\n' && previous == '\r') {
+        return;
+    }
+    if (c != '\r' && c != '\n') {
+        if (inputPosition < (CONSOLE_BUFFER_SIZE - 1)) {
+            consoleInputBuffer[inputPosition++] = c;
+        } else {
+            lineOverflow = true;
         }
-        return -1;
+        return;
     }
 
-    char *token = strtok(cmd, " \t\r\n");
-    while (token != NULL) {
-        if (argc >= max_args) {
-            max_args *= 2;
-            *argv = (char **)realloc(*argv, max_args * sizeof(char *));
-            if (*argv == NULL) {
-                if (consoleIO && consoleIO->debug_print) {
-                    consoleIO->debug_print("Failed to reallocate memory for argv\r\n");
-                }
-                return -1;
-            }
-        }
+    consoleInputBuffer[inputPosition] = '\0';
+    if (lineOverflow) {
+        consolePrintf("line too long (max %d)\r\n", CONSOLE_BUFFER_SIZE - 1);
+    } else if (inputPosition > 0) {
+        processCommand(consoleInputBuffer, 0);
+    }
+    consoleInputBuffer[0] = '\0';
+    inputPosition         = 0;
+    lineOverflow          = false;
+    if (!machineMode) {
+        // The command switched back to interactive mode
+        outputString("> ");
+    }
+}
 
-        (*argv)[argc++] = token;
-        if (consoleIO && consoleIO->debug_print) {
-            consoleIO->debug_print("Parsed argument %d: %s\r\n", argc - 1, token);
+#ifdef CONSOLE_ENABLE_FRAMES
+/**
+ * @brief Collects the bytes of a binary command frame.
+ *
+ * A frame starts with 0x00 followed by CONSOLE_FRAME_SYNC, carries COBS encoded data
+ * and ends with the next 0x00, which dispatches it and returns to text input. Further
+ * 0x00 bytes before the sync byte are ignored. A 0x00 that is not followed by the sync
+ * byte, such as Ctrl-@ or line noise, is dropped and the next byte goes to the line
+ * editor. A frame longer than CONSOLE_FRAME_SIZE is reported and its remaining bytes
+ * are dropped up to the next 0x00; COBS data never contains 0x00, so that byte is the
+ * frame boundary, and none of the frame's bytes can reach the line editor.
+ *
+ * @return false if c is not part of a frame and has to be processed as text
+ */
+static bool processFrameChar(unsigned char c) {
+    if (c == '\0') {
+        if (frameLength > 0 && !frameDiscard) {
+            processFrame(consoleFrameBuffer, frameLength);
         }
-        token = strtok(NULL, " \t\r\n");
+        frameLength  = 0;
+        frameActive  = true;
+        frameSynced  = false;
+        frameDiscard = false;
+        return true;
     }
-
-    if (consoleIO && consoleIO->debug_print) {
-        consoleIO->debug_print("Total arguments parsed: %d\r\n", argc);
+    if (!frameSynced) {
+        frameActive = (c == CONSOLE_FRAME_SYNC);
+        frameSynced = frameActive;
+        return frameActive;
     }
-    return argc;
+    if (frameDiscard) {
+        return true;
+    }
+    if (frameLength == CONSOLE_FRAME_SIZE) {
+        CONSOLE_LOG_WARN("frame too long (max %d)\r\n", CONSOLE_FRAME_SIZE);
+        frameDiscard = true;
+        return true;
+    }
+    consoleFrameBuffer[frameLength++] = c;
+    return true;
 }
 
-static void executeCommand(int argc, char **argv) {
-    command_t *currentCommand = commandList;
-    int found                 = 0;
+/**
+ * @brief Decodes, checks and dispatches one binary command frame.
+ *
+ * The decoded frame holds the command ID (the FNV-1a hash of the command name, little
+ * endian), the arguments as NUL-terminated strings, and the CRC-16/CCITT-FALSE of all
+ * preceding bytes, most significant byte first. The arguments are used in place, so
+ * the command runs without any text parsing.
+ *
+ * @param frame COBS encoded frame without delimiters, decoded in place
+ * @param length Number of bytes in frame
+ */
+static void processFrame(uint8_t *frame, unsigned int length) {
+    const command_t *command = NULL;
+    unsigned int size        = decodeCobs(frame, length);
+    unsigned int idx         = 0;
+    uint32_t id              = 0;
+    int argc                 = 0;
 
-    while (currentCommand) {
-        if (strcmp(currentCommand->command, argv[0]) == 0) {
-            (currentCommand->function)(argc, argv);
-            found = 1;
-            break;
-        }
-        currentCommand = currentCommand->next;
+    if (size < 6 || (size > 6 && frame[size - 3] != '\0')) {
+        CONSOLE_LOG_WARN("malformed frame\r\n");
+        return;
+    }
+    if (crc16(frame, size - 2) != (uint16_t)((frame[size - 2] << 8) | frame[size - 1])) {
+        CONSOLE_LOG_WARN("frame CRC mismatch\r\n");
+        return;
     }
 
-    if (!found) {
-        if (consoleIO && consoleIO->debug_print) {
-            consoleIO->debug_print("command `%s' not found, try `all help'\r\n", (argc == 0) ? "" : argv[0]);
+    id      = (uint32_t)frame[0] | ((uint32_t)frame[1] << 8) | ((uint32_t)frame[2] << 16) | ((uint32_t)frame[3] << 24);
+    command = findCommandById(id);
+    if (command == NULL) {
+        CONSOLE_LOG_WARN("command id %08lx not found\r\n", (unsigned long)id);
+        return;
+    }
+
+    flushOutput();
+    consoleArgv[argc++] = (char *)command->command;
+    for (idx = 4; idx < size - 2; idx += strlen((const char *)frame + idx) + 1) {
+        if (argc >= CONSOLE_MAX_ARGS) {
+            consolePrintf("too many arguments (max %d)\r\n", CONSOLE_MAX_ARGS);
+            return;
         }
+        consoleArgv[argc++] = (char *)frame + idx;
     }
+    consoleArgv[argc] = NULL;
+    executeCommand(argc, consoleArgv);
 }
 
 /**
- * @brief Default help command to list all registered commands.
- *
- * This function displays a list of all commands that have been registered in the command list.
- * It iterates through the linked list of commands and prints each command name.
- * The output is formatted with commands indented by 2 spaces and each on a new line.
- *
- * @param argc Number of arguments (unused but required by command handler signature)
- * @param argv Array of argument strings (unused but required by command handler signature)
- *
- * @note Both argc and argv parameters are explicitly void-cast as they are not used
- *       in the function but are required by the command handler interface.
+ * @brief Decodes a COBS encoded block in place.
+ *
+ * @param data Encoded bytes without the 0x00 delimiter, replaced by the decoded bytes
+ * @param length Number of encoded bytes
+ * @return Number of decoded bytes, or 0 if the encoding is invalid
+ */
+static unsigned int decodeCobs(uint8_t *data, unsigned int length) {
+    unsigned int in  = 0;
+    unsigned int out = 0;
+
+    while (in < length) {
+        uint8_t code = data[in++];
+
+        if (code == 0 || in + code - 1 > length) {
+            return 0;
+        }
+        for (uint8_t idx = 1; idx < code; idx++) {
+            data[out++] = data[in++];
+        }
+        if (code != 0xFF && in < length) {
+            data[out++] = 0;
+        }
+    }
+    return out;
+}
+#endif
+
+#if defined(CONSOLE_ENABLE_FRAMES) || defined(CONSOLE_ENABLE_HISTORY_STORE)
+/**
+ * @brief CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF).
+ */
+static uint16_t crc16(const uint8_t *data, unsigned int length) {
+    uint16_t crc = 0xFFFF;
+
+    while (length--) {
+        crc ^= (uint16_t)(*data++ << 8);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+#endif
+
+/**
+ * @brief Feeds one byte to the escape sequence decoder.
+ *
+ * Recognizes CSI sequences (ESC '[' parameters final) and SS3 sequences (ESC 'O'
+ * final). Up to two numeric parameters are kept; they select the key together with
+ * the final byte through escapeKeys[]. Unknown sequences are consumed silently so
+ * that they never reach the input line.
+ *
+ * @param c Received byte
+ * @return true if the byte was consumed, false if it ended the sequence and must be
+ *         processed as ordinary input
+ */
+static bool handleEscapeChar(unsigned char c) {
+    switch (escapeState) {
+        case ESCAPE_ESC:
+            escapeParamCount = 0;
+            escapeParams[0]  = 0;
+            escapeParams[1]  = 0;
+            if (c == '[') {
+                escapeState = ESCAPE_CSI;
+                return true;
+            }
+            if (c == 'O') {
+                escapeState = ESCAPE_SS3;
+                return true;
+            }
+            break;
+        case ESCAPE_CSI:
+            if (c >= '0' && c <= '9') {
+                if (escapeParamCount < ESCAPE_MAX_PARAMS) {
+                    unsigned int value = escapeParams[escapeParamCount] * 10u + (c - '0');
+
+                    escapeParams[escapeParamCount] = (uint8_t)(value > 0xFF ? 0xFF : value);
+                }
+                return true;
+            }
+            if (c == ';') {
+                if (escapeParamCount < ESCAPE_MAX_PARAMS) {
+                    escapeParamCount++;
+                }
+                return true;
+            }
+            if (c >= 0x20 && c <= 0x3f) {  // private markers and intermediate bytes
+                return true;
+            }
+            if (c >= 0x40 && c <= 0x7e) {  // final byte
+                escapeState = ESCAPE_GROUND;
+                handleKey(lookupEscapeKey(c));
+                return true;
+            }
+            break;
+        case ESCAPE_SS3:
+            if (c >= 0x40 && c <= 0x7e) {
+                escapeState = ESCAPE_GROUND;
+                handleKey(lookupEscapeKey(c));
+                return true;
+            }
+            break;
+        default:
+            break;
+    }
+    escapeState = ESCAPE_GROUND;
+    return false;
+}
+
+/**
+ * @brief Maps the final byte and parameters of a decoded sequence to a key.
+ *
+ * @param final Final byte of the sequence
+ * @return The matching key, or KEY_NONE for sequences the line editor ignores
+ */
+static console_key_t lookupEscapeKey(unsigned char final) {
+    for (size_t idx = 0; idx < sizeof(escapeKeys) / sizeof(escapeKeys[0]); idx++) {
+        const escape_key_t *entry = &escapeKeys[idx];
+
+        if (entry->final == final && entry->parameter == escapeParams[0] && entry->modifier == escapeParams[1]) {
+            return entry->key;
+        }
+    }
+    return KEY_NONE;
+}
+
+static void handleKey(console_key_t key) {
+    switch (key) {
+        case KEY_UP:
+            if (historyDepth < historyCount) {
+                recallHistory(historyDepth + 1, historyPrevious((historyDepth == 0) ? historyHead : historyBrowse));
+            }
+            break;
+        case KEY_DOWN:
+            if (historyDepth > 1) {
+                recallHistory(historyDepth - 1, historyNext(historyBrowse));
+            }
+            break;
+        case KEY_PAGE_UP:  // oldest history entry
+            if (historyDepth < historyCount) {
+                recallHistory(historyCount, historyTail);
+            }
+            break;
+        case KEY_PAGE_DOWN:  // newest history entry
+            if (historyDepth > 1) {
+                recallHistory(1, historyPrevious(historyHead));
+            }
+            break;
+        case KEY_LEFT:
+            if (cursorPosition > 0) {
+                moveCursor(cursorPosition - 1);
+            }
+            break;
+        case KEY_RIGHT:
+            if (cursorPosition < inputPosition) {
+                moveCursor(cursorPosition + 1);
+            }
+            break;
+        case KEY_HOME:
+            moveCursor(0);
+            break;
+        case KEY_END:
+            moveCursor(inputPosition);
+            break;
+        case KEY_WORD_LEFT:
+            moveCursor(previousWord(cursorPosition));
+            break;
+        case KEY_WORD_RIGHT:
+            moveCursor(nextWord(cursorPosition));
+            break;
+        case KEY_DELETE:
+            handleDelete();
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Sends the buffered line editor output.
+ *
+ * Echo, erase sequences and the prompt are collected in consoleOutput and sent with a
+ * single consoleIO->write, or consoleIO->print if the platform has no write function,
+ * once per consoleHandler() pass and before any command runs.
+ */
+static void flushOutput(void) {
+    if (outputLength > 0) {
+        if (consoleIO->write) {
+            consoleIO->write(consoleOutput, outputLength);
+        } else {
+            consoleOutput[outputLength] = '\0';
+            consoleIO->print("%s", consoleOutput);
+        }
+        outputLength = 0;
+    }
+    pendingEcho = 0;
+}
+
+/**
+ * @brief Appends raw bytes to the output buffer, flushing it when full.
+ */
+static void outputBytes(const char *data, size_t length) {
+    size_t chunk = 0;
+
+    pendingEcho = 0;
+    while (length > 0) {
+        if (outputLength == CONSOLE_OUTPUT_SIZE) {
+            flushOutput();
+        }
+        chunk = CONSOLE_OUTPUT_SIZE - outputLength;
+        if (chunk > length) {
+            chunk = length;
+        }
+        memcpy(consoleOutput + outputLength, data, chunk);
+        outputLength += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+static void outputString(const char *text) {
+    outputBytes(text, strlen(text));
+}
+
+/**
+ * @brief Appends one echoed character, which a backspace may take back while it is
+ *        still buffered.
+ *
+ * Unlike outputBytes(), this keeps the count of echo bytes already in the buffer.
+ */
+static void outputEcho(unsigned char c) {
+    if (outputLength == CONSOLE_OUTPUT_SIZE) {
+        flushOutput();
+    }
+    consoleOutput[outputLength++] = (char)c;
+    pendingEcho++;
+}
+
+/**
+ * @brief Appends one formatted conversion, padded to its field width.
+ *
+ * @param sign Sign to put in front of text ("" or "-")
+ * @param text Converted value
+ * @param length Number of characters in text
+ * @param width Minimum field width
+ * @param leftAlign Pad on the right instead of the left
+ * @param zeroPad Pad with zeros between sign and text instead of leading spaces
+ */
+static void outputField(const char *sign, const char *text, size_t length, unsigned int width, bool leftAlign, bool zeroPad) {
+    size_t used    = strlen(sign) + length;
+    size_t padding = (width > used) ? width - used : 0;
+
+    if (!leftAlign && !zeroPad) {
+        for (; padding > 0; padding--) {
+            outputBytes(" ", 1);
+        }
+    }
+    outputString(sign);
+    if (!leftAlign) {
+        for (; padding > 0; padding--) {
+            outputBytes("0", 1);
+        }
+    }
+    outputBytes(text, length);
+    for (; padding > 0; padding--) {
+        outputBytes(" ", 1);
+    }
+}
+
+/**
+ * @brief Appends a CSI cursor movement (ESC '[' distance direction) to the output buffer.
+ *
+ * @param distance Number of columns, at least 1
+ * @param direction 'C' to move right, 'D' to move left
+ */
+static void outputCursorMove(unsigned int distance, char direction) {
+    char sequence[16];
+    size_t length = sizeof(sequence);
+
+    sequence[--length] = direction;
+    do {
+        sequence[--length] = (char)('0' + distance % 10);
+        distance /= 10;
+    } while (distance > 0);
+    sequence[--length] = '[';
+    sequence[--length] = '\x1b';
+    outputBytes(sequence + length, sizeof(sequence) - length);
+}
+
+static void handleBackspace(void) {
+    if (pendingEcho > 0) {
+        // Still in the output buffer, nothing to erase on the terminal
+        outputLength--;
+        pendingEcho--;
+        inputPosition--;
+        cursorPosition--;
+        consoleInputBuffer[inputPosition] = '\0';
+    } else if (cursorPosition == inputPosition && inputPosition > 0) {
+        outputString("\b \b");
+        inputPosition--;
+        cursorPosition--;
+        consoleInputBuffer[inputPosition] = '\0';
+    } else if (cursorPosition > 0) {
+        outputString("\b");
+        cursorPosition--;
+        handleDelete();
+    }
+}
+
+/**
+ * @brief Removes the character under the cursor and redraws the rest of the line.
+ */
+static void handleDelete(void) {
+    unsigned int tail;
+
+    if (cursorPosition >= inputPosition) {
+        return;
+    }
+    tail = inputPosition - cursorPosition - 1;
+    memmove(consoleInputBuffer + cursorPosition, consoleInputBuffer + cursorPosition + 1, tail + 1);
+    inputPosition--;
+    outputString((const char *)consoleInputBuffer + cursorPosition);
+    outputString(" \b");
+    moveCursorLeft(tail);
+}
+
+static void handleEnter(void) {
+    outputString("\r\n");
+    historyDepth = 0;
+    if (inputPosition) {
+        if (!isLatestHistory(consoleInputBuffer, inputPosition)) {
+            addHistory(consoleInputBuffer, inputPosition);
+#ifdef CONSOLE_ENABLE_HISTORY_STORE
+            // Before running the command, which might reset the device
+            appendHistoryRecord(consoleInputBuffer, inputPosition);
+#endif
+        }
+        processCommand(consoleInputBuffer, 0);
+        inputPosition         = 0;
+        cursorPosition        = 0;
+        consoleInputBuffer[0] = '\0';
+        if (machineMode) {
+            // The command switched to machine mode, which has no prompt
+            return;
+        }
+        outputString("\r\n");
+    }
+    outputString("> ");
+}
+
+/**
+ * @brief Appends a line to the history, evicting the oldest entries as needed.
+ *
+ * The history is a byte ring in which every entry is stored as its bytes enclosed by
+ * two length tags, so that it can be walked from either end. Only the bytes of the line
+ * are copied, and short commands take little room: the ring holds as many entries as
+ * fit into CONSOLE_HISTORY_SIZE bytes.
+ *
+ * @param line Line to store
+ * @param length Length of the line, at least 1
+ */
+static void addHistory(const unsigned char *line, unsigned int length) {
+    unsigned int size = length + 2;
+
+    if (size > CONSOLE_HISTORY_SIZE) {
+        return;
+    }
+    while (historyUsed + size > CONSOLE_HISTORY_SIZE) {
+        unsigned int evicted = historyRing[historyTail] + 2u;
+
+        historyTail = historyNext(historyTail);
+        historyUsed -= evicted;
+        historyCount--;
+    }
+
+    historyRing[historyHead] = (unsigned char)length;
+    for (unsigned int idx = 0; idx < length; idx++) {
+        historyRing[(historyHead + 1 + idx) % CONSOLE_HISTORY_SIZE] = line[idx];
+    }
+    historyRing[(historyHead + 1 + length) % CONSOLE_HISTORY_SIZE] = (unsigned char)length;
+    historyHead = (historyHead + size) % CONSOLE_HISTORY_SIZE;
+    historyUsed += size;
+    historyCount++;
+}
+
+/**
+ * @brief Tells whether a line repeats the newest history entry.
+ */
+static bool isLatestHistory(const unsigned char *line, unsigned int length) {
+    unsigned int start = 0;
+
+    if (historyCount == 0) {
+        return false;
+    }
+    start = historyPrevious(historyHead);
+    if (historyRing[start] != length) {
+        return false;
+    }
+    for (unsigned int idx = 0; idx < length; idx++) {
+        if (historyRing[(start + 1 + idx) % CONSOLE_HISTORY_SIZE] != line[idx]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Replaces the input line with a history entry.
+ *
+ * @param depth Position of the entry counted from the newest, which is 1
+ * @param start Offset of the entry in historyRing
+ */
+static void recallHistory(unsigned int depth, unsigned int start) {
+    unsigned char line[CONSOLE_BUFFER_SIZE];
+    unsigned int length = historyRing[start];
+
+    for (unsigned int idx = 0; idx < length; idx++) {
+        line[idx] = historyRing[(start + 1 + idx) % CONSOLE_HISTORY_SIZE];
+    }
+    replaceLine(line, length);
+    historyDepth  = depth;
+    historyBrowse = start;
+}
+
+/**
+ * @brief Returns the offset following a history entry, i.e. the start of the next newer one.
+ */
+static unsigned int historyNext(unsigned int start) {
+    return (start + historyRing[start] + 2u) % CONSOLE_HISTORY_SIZE;
+}
+
+/**
+ * @brief Returns the start of the history entry that ends right before an offset.
+ *
+ * @param end Start of an entry, or historyHead for the newest entry
+ */
+static unsigned int historyPrevious(unsigned int end) {
+    unsigned int length = historyRing[(end + CONSOLE_HISTORY_SIZE - 1) % CONSOLE_HISTORY_SIZE];
+
+    return (end + 2 * CONSOLE_HISTORY_SIZE - length - 2) % CONSOLE_HISTORY_SIZE;
+}
+
+#ifdef CONSOLE_ENABLE_HISTORY_STORE
+/**
+ * @brief Replaces the history in RAM with the entries of the journal.
+ *
+ * Records are read in one pass in journal order, so the usual eviction keeps the
+ * newest ones when the journal holds more than fits into RAM. Reading stops at erased
+ * space; a damaged record also ends the journal and schedules its compaction.
+ */
+static void loadHistory(void) {
+    uint8_t record[CONSOLE_BUFFER_SIZE + 3];
+    uint32_t offset = 0;
+    unsigned int length;
+
+    historyTail   = 0;
+    historyHead   = 0;
+    historyUsed   = 0;
+    historyCount  = 0;
+    historyDepth  = 0;
+    journalOffset = 0;
+    journalDirty  = false;
+    if (historyStore == NULL) {
+        return;
+    }
+
+    while (offset + 4 <= historyStore->size) {
+        if (!historyStore->read(offset, record, 2)) {
+            journalDirty = true;
+            break;
+        }
+        if (record[0] == 0xFF) {  // erased
+            break;
+        }
+        length = record[1];
+        if (record[0] != HISTORY_RECORD_MAGIC || length == 0 || length >= CONSOLE_BUFFER_SIZE ||
+            offset + length + 4 > historyStore->size || !historyStore->read(offset + 2, record + 2, length + 2) ||
+            crc16(record + 1, length + 1) != (uint16_t)((record[length + 2] << 8) | record[length + 3])) {
+            journalDirty = true;
+            break;
+        }
+        addHistory(record + 2, length);
+        offset += length + 4;
+    }
+    journalOffset = offset;
+}
+
+/**
+ * @brief Persists a new history entry, compacting the journal if it has no room.
+ *
+ * @param line Line that was just added to the history in RAM
+ * @param length Length of the line
+ */
+static void appendHistoryRecord(const unsigned char *line, unsigned int length) {
+    if (historyStore == NULL) {
+        return;
+    }
+    if (journalDirty || journalOffset + length + 4 > historyStore->size) {
+        // The history in RAM already holds the new line
+        compactHistoryJournal();
+        return;
+    }
+    writeHistoryRecord(line, length);
+}
+
+/**
+ * @brief Erases the journal and rewrites it from the history in RAM.
+ *
+ * At most half of the store is filled with the newest entries, so that every erase is
+ * followed by several appends even when the store is no larger than the history; the
+ * older entries stay in RAM but are not reloaded after a reset.
+ */
+static void compactHistoryJournal(void) {
+    unsigned char line[CONSOLE_BUFFER_SIZE];
+    unsigned int start  = historyTail;
+    unsigned int count  = historyCount;
+    uint32_t total      = historyUsed + 2u * historyCount;
+    unsigned int length = 0;
+
+    journalOffset = 0;
+    journalDirty  = true;
+    if (!historyStore->erase()) {
+        return;
+    }
+    for (; count > 0 && (total > historyStore->size || (count > 1 && total > historyStore->size / 2)); count--) {
+        total -= historyRing[start] + 4u;
+        start = historyNext(start);
+    }
+    for (; count > 0; count--) {
+        length = historyRing[start];
+        for (unsigned int idx = 0; idx < length; idx++) {
+            line[idx] = historyRing[(start + 1 + idx) % CONSOLE_HISTORY_SIZE];
+        }
+        if (!writeHistoryRecord(line, length)) {
+            return;
+        }
+        start = historyNext(start);
+    }
+    journalDirty = false;
+}
+
+/**
+ * @brief Writes one journal record at journalOffset.
+ *
+ * @return true on success; on failure the journal is marked for compaction
+ */
+static bool writeHistoryRecord(const unsigned char *line, unsigned int length) {
+    uint8_t record[CONSOLE_BUFFER_SIZE + 3];
+    uint16_t crc = 0;
+
+    record[0] = HISTORY_RECORD_MAGIC;
+    record[1] = (uint8_t)length;
+    memcpy(record + 2, line, length);
+    crc                = crc16(record + 1, length + 1);
+    record[length + 2] = (uint8_t)(crc >> 8);
+    record[length + 3] = (uint8_t)crc;
+
+    if (!historyStore->write(journalOffset, record, length + 4)) {
+        journalDirty = true;
+        return false;
+    }
+    journalOffset += length + 4;
+    return true;
+}
+#endif
+
+/**
+ * @brief Inserts a printable character at the cursor.
+ *
+ * Characters typed at the end of the line are simply echoed; pendingEcho counts them
+ * while they are still in the output buffer, so that a backspace can take them back.
+ * An insertion in the middle of the line redraws the tail and puts the cursor back.
+ */
+static void handlePrintableChar(unsigned char c) {
+    unsigned int tail;
+
+    if (inputPosition >= (CONSOLE_BUFFER_SIZE - 1) || c < ' ' || c > '~') {
+        return;
+    }
+    if (cursorPosition == inputPosition) {
+        consoleInputBuffer[inputPosition++] = c;
+        consoleInputBuffer[inputPosition]   = '\0';
+        cursorPosition++;
+        outputEcho(c);
+        return;
+    }
+    tail = inputPosition - cursorPosition;
+    memmove(consoleInputBuffer + cursorPosition + 1, consoleInputBuffer + cursorPosition, tail + 1);
+    consoleInputBuffer[cursorPosition] = c;
+    inputPosition++;
+    outputString((const char *)consoleInputBuffer + cursorPosition);
+    cursorPosition++;
+    moveCursorLeft(tail);
+}
+
+/**
+ * @brief Moves the terminal cursor to a position within the input line.
+ *
+ * Short moves to the right reprint the characters in between, which is cheaper than
+ * the equivalent CSI sequence.
+ *
+ * @param position Target position, at most inputPosition
+ */
+static void moveCursor(unsigned int position) {
+    unsigned int distance;
+
+    if (position < cursorPosition) {
+        moveCursorLeft(cursorPosition - position);
+    } else if (position > cursorPosition) {
+        distance = position - cursorPosition;
+        if (distance < 4) {
+            outputBytes((const char *)consoleInputBuffer + cursorPosition, distance);
+        } else {
+            outputCursorMove(distance, 'C');
+        }
+    }
+    cursorPosition = position;
+}
+
+/**
+ * @brief Moves the terminal cursor left with whichever of backspaces or CSI is shorter.
+ */
+static void moveCursorLeft(unsigned int distance) {
+    if (distance < 4) {
+        outputBytes("\b\b\b", distance);
+    } else {
+        outputCursorMove(distance, 'D');
+    }
+}
+
+static unsigned int previousWord(unsigned int position) {
+    while (position > 0 && consoleInputBuffer[position - 1] == ' ') {
+        position--;
+    }
+    while (position > 0 && consoleInputBuffer[position - 1] != ' ') {
+        position--;
+    }
+    return position;
+}
+
+static unsigned int nextWord(unsigned int position) {
+    while (position < inputPosition && consoleInputBuffer[position] != ' ') {
+        position++;
+    }
+    while (position < inputPosition && consoleInputBuffer[position] == ' ') {
+        position++;
+    }
+    return position;
+}
+
+/**
+ * @brief Replaces the input line, redrawing only what differs on the terminal.
+ *
+ * The part both lines have in common is left alone: the cursor moves to the end of the
+ * common prefix, the rest of the new line overwrites the old one, and an erase to end
+ * of line (ESC "[K") removes what is left of a longer old line. Recalling a history
+ * entry thus costs a few bytes for a similar line instead of erasing and reprinting
+ * the whole line.
+ *
+ * @param line New line, need not be NUL-terminated
+ * @param length Length of the new line, less than CONSOLE_BUFFER_SIZE
+ */
+static void replaceLine(const unsigned char *line, unsigned int length) {
+    unsigned int prefix = 0;
+
+    while (prefix < length && prefix < inputPosition && line[prefix] == consoleInputBuffer[prefix]) {
+        prefix++;
+    }
+    moveCursor(prefix);
+    outputBytes((const char *)line + prefix, length - prefix);
+    if (length < inputPosition) {
+        outputString("\x1b[K");
+    }
+    memcpy(consoleInputBuffer + prefix, line + prefix, length - prefix);
+    consoleInputBuffer[length] = '\0';
+    inputPosition              = length;
+    cursorPosition             = length;
+}
+
+/**
+ * @brief Tokenizes and executes one command line.
+ *
+ * The line is scanned exactly once: parseToArgv() skips leading, separating and
+ * trailing whitespace itself and terminates every token in place, so no bytes are
+ * moved and no separate trimming pass is needed.
+ *
+ * @param cmd Command line, modified in place
+ * @param repeating Unused
+ */
+static void processCommand(unsigned char *cmd, unsigned int repeating) {
+    (void)repeating;
+
+    // Commands print through consoleIO directly; keep the echo in front of their output
+    flushOutput();
+
+    int argc = parseToArgv((char *)cmd, consoleArgv, CONSOLE_MAX_ARGS);
+
+    if (argc > 0) {
+        executeCommand(argc, consoleArgv);
+    } else if (argc == 0) {
+        CONSOLE_LOG_WARN("command `%s' not found, try `all help'\r\n", "");
+    }
+}
+
+/**
+ * @brief Splits a command line into arguments.
+ *
+ * The tokens stay in place in the command buffer and argv is filled with pointers to
+ * them, followed by a NULL entry, so parsing never touches the heap. All parser state
+ * lives in the arguments and on the stack, so unlike strtok() the function is
+ * reentrant and several consoles or threads may parse concurrently.
+ *
+ * @param cmd Command line, modified in place
+ * @param argv Argument array with room for maxArgs + 1 entries
+ * @param maxArgs Maximum number of arguments
+ * @return Number of arguments, or -1 if the line has more than maxArgs arguments
+ */
+static int parseToArgv(char *cmd, char **argv, int maxArgs) {
+    int argc     = 0;
+    int status   = 0;
+    char *cursor = cmd;
+    char *token  = NULL;
+
+    while ((status = nextToken(&cursor, &token)) > 0) {
+        if (argc >= maxArgs) {
+            consolePrintf("too many arguments (max %d)\r\n", maxArgs);
+            argv[0] = NULL;
+            return -1;
+        }
+
+        argv[argc++] = token;
+        CONSOLE_LOG_TRACE("Parsed argument %d: %s\r\n", argc - 1, token);
+    }
+    argv[argc] = NULL;
+
+    if (status < 0) {
+        consolePrintf("unterminated quote\r\n");
+        argv[0] = NULL;
+        return -1;
+    }
+
+    CONSOLE_LOG_TRACE("Total arguments parsed: %d\r\n", argc);
+    return argc;
+}
+
+/**
+ * @brief Extracts the next argument of a command line.
+ *
+ * Reentrant counterpart of strtok(): the scan position is kept in *cursor, which is
+ * advanced past the returned token and its terminating delimiter.
+ *
+ * Arguments may contain delimiters when quoted. Inside double quotes and unquoted
+ * text, a backslash escapes the next character, with \n, \r and \t standing for the
+ * usual control characters; inside single quotes every character is literal. Quotes
+ * and escapes are decoded in place while scanning: the decoded token is never longer
+ * than its source text, so it is written behind the read position in the same buffer.
+ *
+ * @param cursor Scan position, updated on return
+ * @param token Receives the NUL-terminated, decoded token
+ * @return 1 if a token was extracted, 0 at the end of the line, -1 on an unterminated quote
+ */
+static int nextToken(char **cursor, char **token) {
+    char *in   = *cursor;
+    char *out  = NULL;
+    char quote = '\0';
+
+    while (isArgumentDelimiter(*in)) {
+        in++;
+    }
+    if (*in == '\0') {
+        *cursor = in;
+        return 0;
+    }
+
+    *token = in;
+    out    = in;
+    while (*in != '\0') {
+        char c = *in++;
+        if (quote == '\'') {
+            if (c == '\'') {
+                quote = '\0';
+            } else {
+                *out++ = c;
+            }
+        } else if (c == '\\' && *in != '\0') {
+            c = *in++;
+            switch (c) {
+                case 'n':
+                    c = '\n';
+                    break;
+                case 'r':
+                    c = '\r';
+                    break;
+                case 't':
+                    c = '\t';
+                    break;
+                default:
+                    break;
+            }
+            *out++ = c;
+        } else if (quote == '"') {
+            if (c == '"') {
+                quote = '\0';
+            } else {
+                *out++ = c;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (isArgumentDelimiter(c)) {
+            break;
+        } else {
+            *out++ = c;
+        }
+    }
+    // out never passes in, so terminating the token cannot clobber unread input
+    *out    = '\0';
+    *cursor = in;
+    return (quote == '\0') ? 1 : -1;
+}
+
+static bool isArgumentDelimiter(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static void executeCommand(int argc, char **argv) {
+    int depth                = 0;
+    const command_t *command = resolveCommand(argc, argv, &depth);
+
+    if (command == NULL) {
+        CONSOLE_LOG_WARN("command `%s' not found, try `all help'\r\n", (argc == 0) ? "" : argv[0]);
+    } else if (command->schema) {
+        executeTypedCommand(command, argc - depth, argv + depth);
+    } else if (command->function) {
+        (command->function)(argc - depth, argv + depth);
+    } else {
+        printCommandGroup(command);
+    }
+}
+
+/**
+ * @brief Validates the arguments of a command against its schema and dispatches it.
+ *
+ * Every argument is converted exactly once into consoleTypedArgs. The typed function
+ * is only called if the argument count is within the schema limits and all arguments
+ * are valid; otherwise the offending argument and the usage are printed.
+ *
+ * @param command Command with a schema
+ * @param argc Number of tokens, starting with the command name
+ * @param argv Tokens, starting with the command name
+ */
+static void executeTypedCommand(const command_t *command, int argc, char **argv) {
+    const console_schema_t *schema = command->schema;
+    int count                      = argc - 1;
+
+    if (count < schema->required || count > schema->count) {
+        printUsage(command);
+        return;
+    }
+
+    for (int idx = 0; idx < count; idx++) {
+        if (!convertArgument(&schema->args[idx], argv[idx + 1], &consoleTypedArgs[idx])) {
+            consolePrintf("invalid %s `%s'\r\n", schema->args[idx].name, argv[idx + 1]);
+            printUsage(command);
+            return;
+        }
+    }
+
+    (schema->function)(count, consoleTypedArgs);
+}
+
+/**
+ * @brief Converts one argument according to its specification.
+ *
+ * @param spec Argument specification
+ * @param text Argument as typed
+ * @param value Receives the converted value
+ * @return true if the argument is well-formed and within its range or choices
+ */
+static bool convertArgument(const console_arg_spec_t *spec, const char *text, console_arg_t *value) {
+    bool bounded = (spec->min != 0 || spec->max != 0);
+    uint32_t raw = 0;
+
+    switch (spec->type) {
+        case CONSOLE_ARG_INT:
+            if (!parseUnsigned((*text == '-') ? text + 1 : text, 10, &raw)) {
+                return false;
+            }
+            if (*text == '-' ? raw > 0x80000000u : raw > 0x7FFFFFFFu) {
+                return false;
+            }
+            value->i = (*text == '-') ? (int32_t)(0u - raw) : (int32_t)raw;
+            return !bounded || (value->i >= spec->min && value->i <= spec->max);
+        case CONSOLE_ARG_UINT:
+        case CONSOLE_ARG_HEX:
+            if (spec->type == CONSOLE_ARG_HEX && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+                text += 2;
+            }
+            if (!parseUnsigned(text, (spec->type == CONSOLE_ARG_HEX) ? 16 : 10, &value->u)) {
+                return false;
+            }
+            return !bounded || (value->u >= (uint32_t)spec->min && value->u <= (uint32_t)spec->max);
+        case CONSOLE_ARG_ENUM:
+            for (value->u = 0; spec->choices[value->u] != NULL; value->u++) {
+                if (strcmp(spec->choices[value->u], text) == 0) {
+                    return true;
+                }
+            }
+            return false;
+        case CONSOLE_ARG_STRING:
+            value->s = text;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Parses an unsigned integer with overflow detection.
+ *
+ * @param text Digits only, without sign or prefix
+ * @param base 10 or 16
+ * @param value Receives the parsed value
+ * @return true if text is a non-empty sequence of digits that fits into 32 bits
+ */
+static bool parseUnsigned(const char *text, uint32_t base, uint32_t *value) {
+    uint32_t result = 0;
+
+    if (*text == '\0') {
+        return false;
+    }
+    for (; *text != '\0'; text++) {
+        uint32_t digit;
+        if (*text >= '0' && *text <= '9') {
+            digit = (uint32_t)(*text - '0');
+        } else if (base == 16 && *text >= 'a' && *text <= 'f') {
+            digit = (uint32_t)(*text - 'a' + 10);
+        } else if (base == 16 && *text >= 'A' && *text <= 'F') {
+            digit = (uint32_t)(*text - 'A' + 10);
+        } else {
+            return false;
+        }
+        if (result > (0xFFFFFFFFu - digit) / base) {
+            return false;
+        }
+        result = result * base + digit;
+    }
+    *value = result;
+    return true;
+}
+
+/**
+ * @brief Prints the usage line of a command with a schema, e.g. "usage: gpio <pin> [<level>]".
+ */
+static void printUsage(const command_t *command) {
+    const console_schema_t *schema = command->schema;
+
+    consolePrintf("usage: %s", command->command);
+    for (int idx = 0; idx < schema->count; idx++) {
+        consolePrintf((idx < schema->required) ? " <%s>" : " [<%s>]", schema->args[idx].name);
+    }
+    consolePrintf("\r\n");
+}
+
+/**
+ * @brief Resolves the leading tokens of a command line against the command tree.
+ *
+ * argv[0] is looked up through findCommand(); every following token descends into the
+ * subcommands of the current match for as long as one of them has that name, so the
+ * tokens are walked once from left to right.
+ *
+ * @param argc Number of tokens
+ * @param argv Tokens of the command line
+ * @param depth Receives the index in argv of the token naming the returned command
+ * @return Deepest matching command, or NULL if argv[0] is not a command
+ */
+static const command_t *resolveCommand(int argc, char **argv, int *depth) {
+    const command_t *command = (argc > 0) ? findCommand(argv[0]) : NULL;
+
+    *depth = 0;
+    while (command && command->subcommands && *depth + 1 < argc) {
+        const command_t *subcommand = findSubcommand(command->subcommands, argv[*depth + 1]);
+        if (subcommand == NULL) {
+            break;
+        }
+        command = subcommand;
+        (*depth)++;
+    }
+    return command;
+}
+
+/**
+ * @brief Looks up a subcommand by name in a NULL-terminated subcommand array.
+ */
+static const command_t *findSubcommand(const command_t *subcommands, const char *name) {
+    for (; subcommands->command != NULL; subcommands++) {
+        if (strcmp(subcommands->command, name) == 0) {
+            return subcommands;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Looks up a registered command by name.
+ *
+ * The perfect-hash index resolves any indexed name with one hash and one string
+ * compare. On a miss the command list is walked as well, which covers commands that
+ * were linked after the index was built and consoles whose index is disabled.
+ *
+ * @param name Command name (argv[0])
+ * @return Matching command, or NULL if no command has this name
+ */
+static const command_t *findCommand(const char *name) {
+    const command_t *found = indexedCommand(hashCommandName(name));
+
+    if (found && strcmp(found->command, name) == 0) {
+        return found;
+    }
+
+    for (const command_t *curr = commandList; curr; curr = nextCommand(curr)) {
+        if (strcmp(curr->command, name) == 0) {
+            return curr;
+        }
+    }
+    return NULL;
+}
+
+#ifdef CONSOLE_ENABLE_FRAMES
+/**
+ * @brief Looks up a registered command by its ID, the hash of its name.
+ *
+ * Used by binary command frames, which carry the ID instead of the name.
+ *
+ * @param id hashCommandName() of the command name
+ * @return Matching command, or NULL if no command has this ID
+ */
+static const command_t *findCommandById(uint32_t id) {
+    const command_t *found = indexedCommand(id);
+
+    if (found && hashCommandName(found->command) == id) {
+        return found;
+    }
+
+    for (const command_t *curr = commandList; curr; curr = nextCommand(curr)) {
+        if (hashCommandName(curr->command) == id) {
+            return curr;
+        }
+    }
+    return NULL;
+}
+#endif
+
+/**
+ * @brief Returns the only indexed command whose name may have the given hash.
+ *
+ * @param hash hashCommandName() of the wanted name
+ * @return Candidate command that the caller still has to compare, or NULL
+ */
+static const command_t *indexedCommand(uint32_t hash) {
+    uint16_t seed = 0;
+
+    if (commandIndex->size == 0) {
+        return NULL;
+    }
+    seed = commandIndex->seeds[hash % commandIndex->buckets];
+    return commandIndex->slots[commandIndexSlot(hash, seed, commandIndex->size)];
+}
+
+/**
+ * @brief Builds the perfect-hash index over the command list.
+ *
+ * Uses hash-and-displace: names are grouped into buckets of about
+ * COMMAND_INDEX_BUCKET_LOAD entries, and buckets are placed largest first, each one
+ * searching for the smallest seed that maps all of its members to free slots. The
+ * table has exactly one slot per command. When a name is registered twice, the first
+ * registration wins, as with the linear lookup.
+ *
+ * The only scratch memory is indexKeys and indexBucketStart: the commands are collected
+ * in indexSlots, which is free until the buckets are placed, and hashes are recomputed
+ * instead of stored.
+ *
+ * @return true if the index was built, false if lookup has to use the command list
+ */
+static bool buildCommandIndex(void) {
+    unsigned int count   = 0;
+    unsigned int bucket  = 0;
+    unsigned int largest = 0;
+    unsigned int members = 0;
+    unsigned int idx     = 0;
+
+    ramIndex.size = 0;
+    commandIndex  = &ramIndex;
+
+    for (const command_t *curr = commandList; curr; curr = nextCommand(curr)) {
+        if (count == CONSOLE_MAX_COMMANDS) {
+            return false;
+        }
+        indexSlots[count++] = curr;
+    }
+
+    ramIndex.buckets = (count + COMMAND_INDEX_BUCKET_LOAD - 1) / COMMAND_INDEX_BUCKET_LOAD;
+
+    // Counting sort of the keys by bucket, keeping registration order inside a bucket
+    memset(indexBucketStart, 0, sizeof(indexBucketStart));
+    for (idx = 0; idx < count; idx++) {
+        indexBucketStart[hashCommandName(indexSlots[idx]->command) % ramIndex.buckets + 1]++;
+    }
+    for (bucket = 0; bucket < ramIndex.buckets; bucket++) {
+        indexBucketStart[bucket + 1] += indexBucketStart[bucket];
+    }
+    for (idx = 0; idx < count; idx++) {
+        indexKeys[indexBucketStart[hashCommandName(indexSlots[idx]->command) % ramIndex.buckets]++] = indexSlots[idx];
+    }
+    for (bucket = ramIndex.buckets; bucket > 0; bucket--) {
+        indexBucketStart[bucket] = indexBucketStart[bucket - 1];
+    }
+    indexBucketStart[0] = 0;
+
+    memset(indexSlots, 0, sizeof(indexSlots));
+    memset(indexSeeds, 0, sizeof(indexSeeds));
+
+    for (bucket = 0; bucket < ramIndex.buckets; bucket++) {
+        members = (unsigned int)(indexBucketStart[bucket + 1] - indexBucketStart[bucket]);
+        if (members > largest) {
+            largest = members;
+        }
+    }
+
+    // Place crowded buckets first, while most slots are still free
+    for (members = largest; members > 0; members--) {
+        for (bucket = 0; bucket < ramIndex.buckets; bucket++) {
+            if ((unsigned int)(indexBucketStart[bucket + 1] - indexBucketStart[bucket]) == members) {
+                if (!placeIndexBucket(bucket, count)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    ramIndex.size = count;
+    return true;
+}
+
+/**
+ * @brief Finds a displacement seed for one bucket of the command index.
+ *
+ * @param bucket Bucket to place
+ * @param size Number of slots in the index
+ * @return true if every member of the bucket got its own free slot
+ */
+static bool placeIndexBucket(unsigned int bucket, unsigned int size) {
+    unsigned int first = indexBucketStart[bucket];
+    unsigned int last  = indexBucketStart[bucket + 1];
+    unsigned int seed  = 0;
+    unsigned int idx   = 0;
+    unsigned int other = 0;
+
+    // Drop repeated names; identical hashes of different names cannot be separated
+    for (idx = first + 1; idx < last; idx++) {
+        for (other = first; other < idx; other++) {
+            const command_t *key = indexKeys[idx];
+            if (key && indexKeys[other] && hashCommandName(key->command) == hashCommandName(indexKeys[other]->command)) {
+                if (strcmp(key->command, indexKeys[other]->command) != 0) {
+                    return false;
+                }
+                indexKeys[idx] = NULL;
+            }
+        }
+    }
+
+    for (seed = 0; seed <= COMMAND_INDEX_MAX_SEED; seed++) {
+        for (idx = first; idx < last; idx++) {
+            const command_t *key = indexKeys[idx];
+            if (key == NULL) {
+                continue;
+            }
+            unsigned int slot = commandIndexSlot(hashCommandName(key->command), (uint16_t)seed, size);
+            if (indexSlots[slot] != NULL) {
+                break;
+            }
+            indexSlots[slot] = key;
+        }
+        if (idx == last) {
+            indexSeeds[bucket] = (uint16_t)seed;
+            return true;
+        }
+        // Collision: release the slots taken with this seed and try the next one
+        while (idx > first) {
+            idx--;
+            if (indexKeys[idx] != NULL) {
+                indexSlots[commandIndexSlot(hashCommandName(indexKeys[idx]->command), (uint16_t)seed, size)] = NULL;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief FNV-1a hash of a command name.
+ *
+ * @note console.hpp evaluates the same hash at compile time; keep both in sync.
+ */
+static uint32_t hashCommandName(const char *name) {
+    uint32_t hash = 0x811C9DC5u;
+    while (*name) {
+        hash ^= (unsigned char)*name++;
+        hash *= 0x01000193u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Maps a name hash and bucket seed to a slot of the command index.
+ *
+ * @note console.hpp evaluates the same mapping at compile time; keep both in sync.
+ */
+static unsigned int commandIndexSlot(uint32_t hash, uint16_t seed, unsigned int size) {
+    hash += seed * 0x9E3779B9u;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35u;
+    hash ^= hash >> 16;
+    return hash % size;
+}
+
+/**
+ * @brief Default help command to list all registered commands.
+ *
+ * This function displays a list of all commands that have been registered in the command list.
+ * It iterates through the linked list of commands, the commands registered with
+ * CONSOLE_COMMAND(), then the commands of a prebuilt index if one was passed to
+ * consoleInitIndex(), and prints each command name.
+ * The output is formatted with commands indented by 2 spaces and each on a new line;
+ * command groups are marked with a trailing "...".
+ *
+ * With arguments, e.g. `help net`, only the subcommands of the named group are listed.
+ *
+ * @param argc Number of arguments
+ * @param argv Array of argument strings; argv[1..] name a command group
  *
  * @see commandList
+ * @see nextCommand
  * @see command_t
  * @see consoleIO
  */
 static void helpCommand(int argc, char **argv) {
-    (void)argc;
-    (void)argv;
-    consoleIO->print("Available commands:\r\n");
-    command_t *currentCommand = commandList;
-    while (currentCommand) {
-        consoleIO->print("  %s\r\n", currentCommand->command);
-        currentCommand = currentCommand->next;
+    if (argc > 1) {
+        int depth              = 0;
+        const command_t *group = resolveCommand(argc - 1, argv + 1, &depth);
+        if (group == NULL || group->subcommands == NULL || depth + 2 != argc) {
+            consolePrintf("no command group `%s'\r\n", argv[argc - 1]);
+            return;
+        }
+        printCommandGroup(group);
+        return;
+    }
+
+    consolePrintf("Available commands:\r\n");
+    for (const command_t *curr = commandList; curr; curr = nextCommand(curr)) {
+        consolePrintf("  %s%s\r\n", curr->command, curr->subcommands ? " ..." : "");
+    }
+}
+
+/**
+ * @brief Lists the subcommands of a command group.
+ */
+static void printCommandGroup(const command_t *group) {
+    consolePrintf("Available `%s' commands:\r\n", group->command);
+    for (const command_t *subcommand = group->subcommands; subcommand->command != NULL; subcommand++) {
+        consolePrintf("  %s%s\r\n", subcommand->command, subcommand->subcommands ? " ..." : "");
+    }
+}
+
+/**
+ * @brief Prints the registered commands through debug_print after initialization.
+ *
+ * @param indexed Result of building the command index
+ */
+static void printAvailableCommands(bool indexed) {
+    if (CONSOLE_LOG_ENABLED(CONSOLE_LOG_LEVEL_INFO)) {
+        CONSOLE_LOG_INFO("Available commands:\r\n");
+        for (const command_t *curr = commandList; curr; curr = nextCommand(curr)) {
+            CONSOLE_LOG_INFO("  %s\r\n", curr->command);
+        }
+        CONSOLE_LOG_INFO("\r\n");
+    }
+    if (!indexed) {
+        CONSOLE_LOG_WARN("Command index disabled, using linear lookup\r\n");
+    }
+}
+
+/**
+ * @brief Iterates over all registered commands.
+ *
+ * Commands are visited in three runs: the command list starting at commandList, the
+ * descriptors registered with CONSOLE_COMMAND(), then the commands of a prebuilt index.
+ *
+ * @param command Command returned by the previous call, or commandList to start
+ * @return Next command, or NULL after the last one
+ */
+static const command_t *nextCommand(const command_t *command) {
+    const command_t *indexStart = commandIndex->commands;
+    const command_t *indexStop  = indexStart ? indexStart + commandIndex->size : NULL;
+
+    if (command >= SECTION_COMMANDS_START && command < SECTION_COMMANDS_STOP) {
+        command++;
+        if (command < SECTION_COMMANDS_STOP) {
+            return command;
+        }
+    } else if (command >= indexStart && command < indexStop) {
+        command++;
+        return (command < indexStop) ? command : NULL;
+    } else if (command->next) {
+        return command->next;
+    } else if (SECTION_COMMANDS_START != SECTION_COMMANDS_STOP) {
+        return SECTION_COMMANDS_START;
     }
+    return (indexStart != indexStop) ? indexStart : NULL;
 }
 
 #pragma endregion Private Functions
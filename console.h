@@ -14,6 +14,7 @@ extern "C" {
 
 #pragma region includes
 
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -40,25 +41,141 @@ extern "C" {
  * int ch = console.getchar();
  * @endcode
  *
+ * Input may be non-blocking: getchar returns CONSOLE_NO_DATA (or any negative value)
+ * when no character is pending, and consoleHandler() then returns immediately.
+ *
  * @field debug_print Function pointer for debug messages (printf-like format)
- * @field print Function pointer for normal output (printf-like format)
- * @field getchar Function pointer for character input
+ * @field print Function pointer for normal output (printf-like format). The console
+ *        formats its own output with consolePrintf() and only uses print to send it
+ *        when write is NULL
+ * @field getchar Function pointer for character input, CONSOLE_NO_DATA if none is pending
+ * @field available Optional function pointer returning the number of pending input
+ *        characters, or NULL if the platform cannot tell
+ * @field ticks Optional function pointer returning a free-running tick counter (e.g. a
+ *        millisecond or cycle counter) that bounds consoleHandlerBudget(), or NULL
+ * @field write Optional function pointer sending raw bytes. The echo, erase sequences
+ *        and prompt are buffered and sent with one write per consoleHandler() pass; if
+ *        NULL, the buffer is sent through print instead
  */
 typedef struct {
     void (*debug_print)(const char *format, ...);
     void (*print)(const char *format, ...);
     int (*getchar)(void);
+    int (*available)(void);
+    uint32_t (*ticks)(void);
+    void (*write)(const void *data, size_t length);
 } console_io_t;
 
+/**
+ * @brief Storage callbacks of the persistent command history
+ *
+ * @details Describes a journal region of `size` bytes, typically a flash sector or a
+ * file. Offsets are relative to the start of the region. The console only writes to
+ * erased space, in increasing order, and erases the whole region when it compacts the
+ * journal. All callbacks return true on success. Available with
+ * CONSOLE_ENABLE_HISTORY_STORE; see consoleSetHistoryStore().
+ *
+ * @field size Size of the journal region in bytes
+ * @field read Reads bytes; erased space must read as 0xFF
+ * @field write Programs previously erased bytes
+ * @field erase Erases the whole region to 0xFF
+ */
+typedef struct {
+    uint32_t size;
+    bool (*read)(uint32_t offset, void *data, size_t length);
+    bool (*write)(uint32_t offset, const void *data, size_t length);
+    bool (*erase)(void);
+} console_history_store_t;
+
+/**
+ * @brief Type of a command argument validated by the console
+ */
+typedef enum {
+    CONSOLE_ARG_INT,    /**< Signed decimal integer, delivered in console_arg_t::i */
+    CONSOLE_ARG_UINT,   /**< Unsigned decimal integer, delivered in console_arg_t::u */
+    CONSOLE_ARG_HEX,    /**< Unsigned hexadecimal integer with optional 0x prefix, delivered in console_arg_t::u */
+    CONSOLE_ARG_ENUM,   /**< One of the strings in choices, delivered as its index in console_arg_t::u */
+    CONSOLE_ARG_STRING, /**< Any string, delivered in console_arg_t::s */
+} console_arg_type_t;
+
+/**
+ * @brief Specification of one command argument
+ *
+ * Integer arguments are checked against the inclusive range [min, max] unless both
+ * bounds are 0. For CONSOLE_ARG_UINT and CONSOLE_ARG_HEX the bounds are compared as
+ * uint32_t.
+ */
+typedef struct {
+    const char *name;           /**< Argument name used in usage and error messages */
+    console_arg_type_t type;    /**< Argument type */
+    int32_t min;                /**< Inclusive minimum of an integer argument */
+    int32_t max;                /**< Inclusive maximum of an integer argument */
+    const char *const *choices; /**< NULL-terminated accepted strings of a CONSOLE_ARG_ENUM argument */
+} console_arg_spec_t;
+
+/**
+ * @brief Validated command argument
+ */
+typedef union {
+    int32_t i;     /**< Value of a CONSOLE_ARG_INT argument */
+    uint32_t u;    /**< Value of a CONSOLE_ARG_UINT or CONSOLE_ARG_HEX argument, index of a CONSOLE_ARG_ENUM choice */
+    const char *s; /**< Value of a CONSOLE_ARG_STRING argument */
+} console_arg_t;
+
+/**
+ * @brief Argument schema of a command
+ *
+ * When a command has a schema, the console converts and validates its arguments once
+ * before dispatch and calls the typed handler with the converted values; the handler
+ * is not invoked if any argument is missing, surplus or invalid. The typed argument
+ * array starts with the first argument after the command name.
+ *
+ * Example:
+ * @code
+ * static const char *const levels[] = {"low", "high", NULL};
+ * static const console_arg_spec_t gpioArgs[] = {
+ *   {"pin", CONSOLE_ARG_UINT, 0, 15, NULL},
+ *   {"level", CONSOLE_ARG_ENUM, 0, 0, levels},
+ * };
+ * static const console_schema_t gpioSchema = {gpioArgs, 2, 2, gpio_handler};
+ *
+ * static void gpio_handler(int argc, const console_arg_t *args) {
+ *   gpio_write(args[0].u, args[1].u);
+ * }
+ * @endcode
+ */
+typedef struct {
+    const console_arg_spec_t *args;                        /**< Argument specifications, in order */
+    uint8_t count;                                         /**< Number of specifications, i.e. maximum argument count */
+    uint8_t required;                                      /**< Minimum argument count */
+    void (*function)(int argc, const console_arg_t *args); /**< Typed function to execute the command */
+} console_schema_t;
+
 /**
  * @brief Structure for command handling
  *
+ * A command can group further commands through `subcommands`, e.g. "net stats" and
+ * "net reset". The console resolves as many tokens of the command line as match the
+ * command tree, then calls the deepest match with argv starting at its own name. A
+ * group without function prints its subcommands when invoked on its own.
+ *
+ * A command with a `schema` gets its arguments validated and converted by the console
+ * and is dispatched to the schema's typed function instead of `function`.
+ *
  * Example:
  * @code
+ * static const command_t netCommands[] = {
+ *   {"stats", net_stats_handler, NULL, NULL, NULL},
+ *   {"reset", net_reset_handler, NULL, NULL, NULL},
+ *   {NULL, NULL, NULL, NULL, NULL}  // End of subcommands
+ * };
+ *
  * command_t cmd = {
- *   .command = "help",
- *   .function = help_handler,
- *   .next = NULL
+ *   .command = "net",
+ *   .function = NULL,
+ *   .next = NULL,
+ *   .subcommands = netCommands,
+ *   .schema = NULL
  * };
  * @endcode
  */
@@ -66,21 +183,172 @@ typedef struct command_t {
     const char *command;                     /**< Command string */
     void (*function)(int argc, char **argv); /**< Function to execute the command */
     struct command_t *next;                  /**< Pointer to the next command in the list */
+    const struct command_t *subcommands;     /**< NULL-terminated array of subcommands, or NULL */
+    const console_schema_t *schema;          /**< Argument schema and typed function, or NULL */
 } command_t;
 
+/**
+ * @brief Perfect-hash index over a set of command names
+ *
+ * Commands are split into buckets by the FNV-1a hash of their name, and every bucket
+ * stores the displacement seed that sends each of its members to a distinct slot, so
+ * a lookup costs one hash and a single string compare.
+ *
+ * consoleInit() builds an index over the command list in RAM. An index can also be
+ * generated at compile time with console.hpp and passed to consoleInitIndex().
+ */
+typedef struct {
+    const command_t *commands;     /**< Commands in name order, NULL if they live in the command list */
+    const command_t *const *slots; /**< Command per slot, NULL for unused slots */
+    const uint16_t *seeds;         /**< Displacement seed per bucket */
+    unsigned int size;             /**< Number of slots, 0 if the index is disabled */
+    unsigned int buckets;          /**< Number of buckets */
+} command_index_t;
+
 #pragma endregion typedef
 
 #pragma region defines
 
 #define CONSOLE_BUFFER_SIZE    128
 #define CONSOLE_HISTORY_LENGTH 4
+#define CONSOLE_NO_DATA        (-1) /**< Returned by console_io_t::getchar when no input is pending */
+
+/**
+ * @brief Size in bytes of the command history.
+ *
+ * Entries are packed with two bytes of overhead each, and the oldest entries are
+ * evicted when a new one does not fit. The default keeps the footprint of
+ * CONSOLE_HISTORY_LENGTH full-length lines.
+ */
+#ifndef CONSOLE_HISTORY_SIZE
+#define CONSOLE_HISTORY_SIZE (CONSOLE_HISTORY_LENGTH * CONSOLE_BUFFER_SIZE)
+#endif
+
+#if CONSOLE_BUFFER_SIZE > 256
+#error "CONSOLE_BUFFER_SIZE must not exceed 256, history entries store their length in one byte"
+#endif
+
+/**
+ * @brief Size of the buffer that collects echo, erase sequences and the prompt.
+ *
+ * The buffer is sent when full, once per consoleHandler() pass and before a command
+ * runs.
+ */
+#ifndef CONSOLE_OUTPUT_SIZE
+#define CONSOLE_OUTPUT_SIZE CONSOLE_BUFFER_SIZE
+#endif
+
+/**
+ * @brief Maximum number of arguments of a command line, including the command name.
+ *
+ * Longer command lines are rejected with an error instead of being executed.
+ */
+#ifndef CONSOLE_MAX_ARGS
+#define CONSOLE_MAX_ARGS 10
+#endif
+
+/**
+ * @brief Maximum number of commands covered by the perfect-hash command index.
+ *
+ * If more commands are registered, the index is not built and lookup falls back to
+ * walking the command list.
+ *
+ * The RAM index takes one pointer plus half a byte per command, and building it needs
+ * the same again as scratch that stays reserved: 9 bytes per command on a 32-bit
+ * target, e.g. 4.5 KB for 512 commands. An index generated at compile time and passed
+ * to consoleInitIndex() needs none of it, so keep the value small in that case.
+ */
+#ifndef CONSOLE_MAX_COMMANDS
+#define CONSOLE_MAX_COMMANDS 64
+#endif
+
+/**
+ * @brief Levels of the console's own debug messages.
+ *
+ * CONSOLE_LOG_LEVEL selects the highest level compiled in; messages above it compile to
+ * nothing, so e.g. a build with CONSOLE_LOG_LEVEL_WARN has no tracing in the tokenizer.
+ * consoleSetLogLevel() lowers the level further at run time.
+ */
+#define CONSOLE_LOG_LEVEL_NONE  0 /**< No debug messages */
+#define CONSOLE_LOG_LEVEL_ERROR 1 /**< Failures of the console itself, e.g. out of memory */
+#define CONSOLE_LOG_LEVEL_WARN  2 /**< Rejected input such as unknown commands or bad frames */
+#define CONSOLE_LOG_LEVEL_INFO  3 /**< Command list after initialization */
+#define CONSOLE_LOG_LEVEL_TRACE 4 /**< Every parsed argument of every command line */
+
+#ifndef CONSOLE_LOG_LEVEL
+#define CONSOLE_LOG_LEVEL CONSOLE_LOG_LEVEL_TRACE
+#endif
+
+/**
+ * @brief Binary command frames on the console port
+ *
+ * When CONSOLE_ENABLE_FRAMES is defined, a 0x00 byte followed by CONSOLE_FRAME_SYNC
+ * on the input starts a COBS encoded frame that ends with the next 0x00. The decoded
+ * frame carries a command ID, the arguments as NUL-terminated strings and a
+ * CRC-16/CCITT-FALSE, and is dispatched into the registered commands without echo or
+ * text parsing. Text input keeps working on the same port: typed text never contains
+ * 0x00, and a stray 0x00 without the sync byte is ignored.
+ *
+ * CONSOLE_FRAME_SIZE is the maximum encoded frame length, without the delimiters and
+ * the sync byte. Longer frames are dropped up to their closing 0x00.
+ */
+#if defined(CONSOLE_ENABLE_FRAMES) && !defined(CONSOLE_FRAME_SIZE)
+#define CONSOLE_FRAME_SIZE CONSOLE_BUFFER_SIZE
+#endif
+
+// Never part of ASCII or UTF-8 text
+#define CONSOLE_FRAME_SYNC 0xFE
+
+/**
+ * @brief Self-registration of commands through a dedicated linker section
+ *
+ * Available with GCC or Clang on ELF targets unless CONSOLE_NO_SECTION_COMMANDS is
+ * defined. CONSOLE_COMMAND() places a constant command_t descriptor into the
+ * "console_commands" section, and every console init function picks up all
+ * descriptors between the __start_console_commands and __stop_console_commands
+ * symbols that the linker provides, so modules register their commands without
+ * editing a central table and the descriptors stay in read-only memory.
+ *
+ * Example:
+ * @code
+ * static void helloCommand(int argc, char **argv) { ... }
+ * CONSOLE_COMMAND("hello", helloCommand);
+ * CONSOLE_COMMAND("hi", helloCommand);  // Alias, handlers may be registered more than once
+ * @endcode
+ *
+ * @note When linking with --gc-sections and -z start-stop-gc, or with a linker script
+ *       that places the section explicitly, keep it with KEEP(*(console_commands)).
+ */
+#if defined(__GNUC__) && defined(__ELF__) && !defined(CONSOLE_NO_SECTION_COMMANDS)
+#define CONSOLE_SECTION_COMMANDS 1
+
+// Two levels so that __COUNTER__ is expanded before pasting
+#define CONSOLE_PASTE_(a, b) a##b
+#define CONSOLE_PASTE(a, b)  CONSOLE_PASTE_(a, b)
+
+#define CONSOLE_COMMAND(name, fn)                                                                                      \
+    static const command_t CONSOLE_PASTE(consoleCommand_, __COUNTER__)                                                 \
+        __attribute__((used, section("console_commands"), aligned(__alignof__(command_t)))) = {name, fn, NULL, NULL, NULL}
+#endif
 
 #pragma endregion defines
 
 #pragma region Exported Functions
 
 void consoleInit(const console_io_t *io, const command_t *commands);
-void consoleHandler(void);
+void consoleInitInPlace(const console_io_t *io, command_t *commands);
+void consoleInitIndex(const console_io_t *io, const command_index_t *index);
+bool consoleHandler(void);
+unsigned int consoleHandlerBudget(unsigned int maxBytes, uint32_t maxTicks);
+bool consoleInputAvailable(void);
+void consoleFeed(const void *buf, size_t len);
+void consoleSetMachineMode(bool enabled);
+#ifdef CONSOLE_ENABLE_HISTORY_STORE
+void consoleSetHistoryStore(const console_history_store_t *store);
+#endif
+void consoleSetLogLevel(uint8_t level);
+void consolePrintf(const char *format, ...);
+void consoleVprintf(const char *format, va_list args);
 
 #pragma endregion Exported Functions
 
@@ -0,0 +1,248 @@
+/**
+ * @file console.hpp
+ * @brief Compile-time command index for C++17 and later
+ * @version 1.0
+ * @date 2024-11-13
+ *
+ * Builds the perfect-hash command index of console.h entirely at compile time. The
+ * resulting tables are constexpr, so they are placed in read-only memory and can be
+ * passed to consoleInitIndex() without any copying or hashing at boot.
+ *
+ * Example:
+ * @code
+ * #include "console.hpp"
+ *
+ * static constexpr auto commands = console::makeCommandTable({
+ *     {"hello", helloCommand},
+ *     {"reset", resetCommand},
+ * });
+ *
+ * int main(void) {
+ *     consoleInitIndex(&std_io, &console::CommandIndex<commands>::index);
+ *     ...
+ * }
+ * @endcode
+ *
+ * Duplicate or empty command names are reported as compile errors.
+ */
+
+#ifndef CONSOLE_HPP
+#define CONSOLE_HPP
+
+#if __cplusplus < 201703L
+#error "console.hpp requires C++17 or later"
+#endif
+
+#pragma region includes
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include "console.h"
+
+#pragma endregion includes
+
+namespace console {
+
+#pragma region typedef
+
+/**
+ * @brief Command entry of a compile-time command table
+ */
+struct Command {
+    const char *name;                         /**< Command string */
+    void (*function)(int argc, char **argv);  /**< Function to execute the command */
+    const command_t *subcommands   = nullptr; /**< NULL-terminated array of subcommands, or NULL */
+    const console_schema_t *schema = nullptr; /**< Argument schema and typed function, or NULL */
+};
+
+namespace detail {
+
+constexpr std::size_t kBucketLoad = 4;
+constexpr std::uint32_t kMaxSeed  = 0xFFFF;
+
+constexpr std::size_t bucketCount(std::size_t count) {
+    return (count + kBucketLoad - 1) / kBucketLoad;
+}
+
+// Same as hashCommandName() in console.c
+constexpr std::uint32_t hashName(const char *name) {
+    std::uint32_t hash = 0x811C9DC5u;
+    while (*name) {
+        hash ^= static_cast<unsigned char>(*name++);
+        hash *= 0x01000193u;
+    }
+    return hash;
+}
+
+// Same as commandIndexSlot() in console.c
+constexpr std::size_t slotOf(std::uint32_t hash, std::uint32_t seed, std::size_t size) {
+    hash += seed * 0x9E3779B9u;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35u;
+    hash ^= hash >> 16;
+    return hash % size;
+}
+
+constexpr int compareNames(const char *lhs, const char *rhs) {
+    while (*lhs && *lhs == *rhs) {
+        lhs++;
+        rhs++;
+    }
+    return static_cast<unsigned char>(*lhs) - static_cast<unsigned char>(*rhs);
+}
+
+// Not constexpr on purpose: reaching it while building a table at compile time is a
+// compile error that quotes the reason, without needing exceptions
+[[noreturn]] inline void invalidTable(const char *reason) {
+    (void)reason;
+    std::abort();
+}
+
+}  // namespace detail
+
+/**
+ * @brief Command table sorted by name, with its perfect-hash slot assignment
+ *
+ * @tparam N Number of commands
+ */
+template <std::size_t N>
+struct CommandTable {
+    static_assert(N > 0, "command table must not be empty");
+    static constexpr std::size_t kBuckets = detail::bucketCount(N);
+
+    command_t commands[N];         /**< Commands in name order */
+    std::uint16_t slots[N];        /**< Index into commands per slot */
+    std::uint16_t seeds[kBuckets]; /**< Displacement seed per bucket */
+};
+
+#pragma endregion typedef
+
+#pragma region Exported Functions
+
+/**
+ * @brief Sorts the commands by name and computes their perfect-hash slots
+ *
+ * Mirrors buildCommandIndex() in console.c: buckets are placed largest first, each one
+ * taking the smallest seed that maps all of its members to free slots.
+ *
+ * @param entries Commands to index
+ * @return Table to be passed to CommandIndex
+ */
+template <std::size_t N>
+constexpr CommandTable<N> makeCommandTable(const Command (&entries)[N]) {
+    CommandTable<N> table{};
+    std::uint32_t hashes[N]{};
+    bool used[N]{};
+
+    for (std::size_t idx = 0; idx < N; idx++) {
+        if (entries[idx].name == nullptr || *entries[idx].name == '\0' || (entries[idx].function == nullptr && entries[idx].subcommands == nullptr && entries[idx].schema == nullptr)) {
+            detail::invalidTable("console: command entries need a name and a function, subcommands or a schema");
+        }
+        std::size_t pos = idx;
+        while (pos > 0 && detail::compareNames(table.commands[pos - 1].command, entries[idx].name) > 0) {
+            table.commands[pos] = table.commands[pos - 1];
+            pos--;
+        }
+        table.commands[pos] = command_t{entries[idx].name, entries[idx].function, nullptr, entries[idx].subcommands, entries[idx].schema};
+    }
+    for (std::size_t idx = 0; idx < N; idx++) {
+        if (idx > 0 && detail::compareNames(table.commands[idx - 1].command, table.commands[idx].command) == 0) {
+            detail::invalidTable("console: duplicate command name");
+        }
+        hashes[idx] = detail::hashName(table.commands[idx].command);
+    }
+
+    std::size_t largest = 0;
+    for (std::size_t bucket = 0; bucket < table.kBuckets; bucket++) {
+        std::size_t members = 0;
+        for (std::size_t idx = 0; idx < N; idx++) {
+            members += (hashes[idx] % table.kBuckets == bucket) ? 1 : 0;
+        }
+        largest = (members > largest) ? members : largest;
+    }
+
+    for (std::size_t members = largest; members > 0; members--) {
+        for (std::size_t bucket = 0; bucket < table.kBuckets; bucket++) {
+            std::size_t keys[N]{};
+            std::size_t count = 0;
+            for (std::size_t idx = 0; idx < N; idx++) {
+                if (hashes[idx] % table.kBuckets == bucket) {
+                    keys[count++] = idx;
+                }
+            }
+            if (count != members) {
+                continue;
+            }
+
+            std::uint32_t seed = 0;
+            for (; seed <= detail::kMaxSeed; seed++) {
+                std::size_t placed = 0;
+                for (; placed < count; placed++) {
+                    std::size_t slot = detail::slotOf(hashes[keys[placed]], seed, N);
+                    if (used[slot]) {
+                        break;
+                    }
+                    used[slot]        = true;
+                    table.slots[slot] = static_cast<std::uint16_t>(keys[placed]);
+                }
+                if (placed == count) {
+                    break;
+                }
+                while (placed > 0) {
+                    placed--;
+                    used[detail::slotOf(hashes[keys[placed]], seed, N)] = false;
+                }
+            }
+            if (seed > detail::kMaxSeed) {
+                detail::invalidTable("console: command names cannot be separated by the index hash");
+            }
+            table.seeds[bucket] = static_cast<std::uint16_t>(seed);
+        }
+    }
+    return table;
+}
+
+/**
+ * @brief Read-only command index over a compile-time command table
+ *
+ * @tparam Table Command table with static storage duration, built by makeCommandTable()
+ */
+template <const auto &Table>
+struct CommandIndex {
+   private:
+    static constexpr std::size_t kSize = sizeof(Table.slots) / sizeof(Table.slots[0]);
+
+    struct Slots {
+        const command_t *slots[kSize];
+    };
+
+    static constexpr Slots makeSlots() {
+        Slots result{};
+        for (std::size_t idx = 0; idx < kSize; idx++) {
+            result.slots[idx] = &Table.commands[Table.slots[idx]];
+        }
+        return result;
+    }
+
+    static constexpr Slots slots = makeSlots();
+
+   public:
+    /** Index to be passed to consoleInitIndex() */
+    static constexpr command_index_t index = {
+        Table.commands,
+        slots.slots,
+        Table.seeds,
+        static_cast<unsigned int>(kSize),
+        static_cast<unsigned int>(sizeof(Table.seeds) / sizeof(Table.seeds[0])),
+    };
+};
+
+#pragma endregion Exported Functions
+
+}  // namespace console
+
+#endif  // CONSOLE_HPP
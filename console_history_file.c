@@ -0,0 +1,127 @@
+/**
+ * @file console_history_file.c
+ * @brief File backend of the persistent command history for POSIX hosts
+ * @version 1.0
+ * @date 2024-11-13
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "console_history_file.h"
+
+#ifdef CONSOLE_ENABLE_HISTORY_STORE
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma region Private Function Prototypes
+
+static bool fileRead(uint32_t offset, void *data, size_t length);
+static bool fileWrite(uint32_t offset, const void *data, size_t length);
+static bool fileErase(void);
+
+#pragma endregion Private Function Prototypes
+
+#pragma region variables
+
+static int historyFile = -1;
+static console_history_store_t fileStore = {0, fileRead, fileWrite, fileErase};
+
+#pragma endregion variables
+
+#pragma region External Functions
+
+/**
+ * @brief Opens or creates the history journal file
+ *
+ * The file behaves like an erased flash region of the given size: it grows as records
+ * are appended, and the bytes past its end read as 0xFF.
+ *
+ * Example usage:
+ * @code
+ * consoleSetHistoryStore(consoleHistoryFileOpen(".console_history", 4096));
+ * consoleInit(&io, commands);
+ * @endcode
+ *
+ * @param path Path of the journal file
+ * @param size Maximum size of the journal in bytes
+ * @return Store to pass to consoleSetHistoryStore(), or NULL if the file cannot be opened
+ */
+const console_history_store_t *consoleHistoryFileOpen(const char *path, uint32_t size) {
+    consoleHistoryFileClose();
+    historyFile = open(path, O_RDWR | O_CREAT, 0600);
+    if (historyFile < 0) {
+        return NULL;
+    }
+    fileStore.size = size;
+    return &fileStore;
+}
+
+/**
+ * @brief Closes the history journal file
+ *
+ * @note Call consoleSetHistoryStore(NULL) first if the console is still running.
+ */
+void consoleHistoryFileClose(void) {
+    if (historyFile >= 0) {
+        close(historyFile);
+        historyFile = -1;
+    }
+}
+
+#pragma endregion External Functions
+
+#pragma region Private Functions
+
+static bool fileRead(uint32_t offset, void *data, size_t length) {
+    uint8_t *out = (uint8_t *)data;
+    ssize_t count;
+
+    while (length > 0) {
+        count = pread(historyFile, out, length, (off_t)offset);
+        if (count < 0) {
+            return false;
+        }
+        if (count == 0) {  // end of file, unwritten space
+            memset(out, 0xFF, length);
+            break;
+        }
+        out += count;
+        offset += (uint32_t)count;
+        length -= (size_t)count;
+    }
+    return true;
+}
+
+static bool fileWrite(uint32_t offset, const void *data, size_t length) {
+    const uint8_t *in = (const uint8_t *)data;
+    ssize_t count;
+
+    while (length > 0) {
+        count = pwrite(historyFile, in, length, (off_t)offset);
+        if (count <= 0) {
+            return false;
+        }
+        in += count;
+        offset += (uint32_t)count;
+        length -= (size_t)count;
+    }
+    return fsync(historyFile) == 0;
+}
+
+static bool fileErase(void) {
+    return ftruncate(historyFile, 0) == 0 && fsync(historyFile) == 0;
+}
+
+#pragma endregion Private Functions
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CONSOLE_ENABLE_HISTORY_STORE
@@ -0,0 +1,36 @@
+/**
+ * @file console_history_file.h
+ * @brief File backend of the persistent command history for POSIX hosts
+ * @version 1.0
+ * @date 2024-11-13
+ */
+
+#ifndef CONSOLE_HISTORY_FILE_H
+#define CONSOLE_HISTORY_FILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma region includes
+
+#include <stdint.h>
+
+#include "console.h"
+
+#pragma endregion includes
+
+#pragma region Exported Functions
+
+#ifdef CONSOLE_ENABLE_HISTORY_STORE
+const console_history_store_t *consoleHistoryFileOpen(const char *path, uint32_t size);
+void consoleHistoryFileClose(void);
+#endif
+
+#pragma endregion Exported Functions
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CONSOLE_HISTORY_FILE_H
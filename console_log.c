@@ -0,0 +1,200 @@
+/**
+ * @file console_log.c
+ * @brief Deferred binary logging with format strings replaced by IDs
+ * @version 1.0
+ * @date 2024-11-13
+ */
+
+#include "console_log.h"
+
+#include "console_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma region includes
+#include <stdarg.h>
+#include <string.h>
+#pragma endregion includes
+
+#pragma region Private Function Prototypes
+
+static bool appendWord(uint8_t *record, size_t *length, uint32_t value);
+static bool appendString(uint8_t *record, size_t *length, const char *string);
+
+#pragma endregion Private Function Prototypes
+
+#pragma region variables
+
+// Provided by the linker; weak so that an image without any deferred log call still links
+extern const char __start_console_log[] __attribute__((weak));
+
+static console_ring_t logRing;
+static bool logReady;
+static uint32_t logDropped;
+
+#pragma endregion variables
+
+#pragma region External Functions
+
+/**
+ * @brief Initializes the log ring over caller-provided storage
+ *
+ * Records logged before initialization are discarded.
+ *
+ * @param storage Storage of at least size bytes, owned by the caller
+ * @param size Capacity in bytes, a power of two
+ * @return true on success, false if size is not a power of two
+ */
+bool consoleLogInit(void *storage, uint32_t size) {
+    logDropped = 0;
+    logReady   = consoleRingInit(&logRing, storage, size);
+    return logReady;
+}
+
+/**
+ * @brief Appends one log record to the log ring
+ *
+ * Called through CONSOLE_LOG_DEFERRED(). The record holds the offset of format in the
+ * "console_log" section as a 16-bit little-endian ID, followed by the arguments in the
+ * order of the conversions in format: 32-bit little-endian values for integers,
+ * characters and '*' widths, and NUL-terminated contents for strings. A string is
+ * truncated if the record would exceed CONSOLE_LOG_RECORD_SIZE; a record that does not
+ * fit into the ring is dropped as a whole, so the stream always consists of complete
+ * records. A format string placed beyond the first 64 KiB of the section has no valid
+ * ID; its records are dropped as well.
+ *
+ * @param format Format string in the "console_log" section
+ *
+ * @note Not reentrant: records must be logged from one context at a time, e.g. only
+ *       from the main loop.
+ */
+void consoleLogWrite(const char *format, ...) {
+    uint8_t record[CONSOLE_LOG_RECORD_SIZE];
+    uint32_t id   = (uint32_t)(format - __start_console_log);
+    size_t length = 0;
+    bool fits     = true;
+    va_list args;
+
+    if (!logReady) {
+        return;
+    }
+    if (id > 0xFFFF) {
+        logDropped++;
+        return;
+    }
+    record[length++] = (uint8_t)id;
+    record[length++] = (uint8_t)(id >> 8);
+
+    va_start(args, format);
+    for (const char *cursor = format; fits && *cursor; cursor++) {
+        if (*cursor != '%') {
+            continue;
+        }
+        cursor++;
+        while (*cursor == '-' || *cursor == '0' || *cursor == '.' || *cursor == '*' || (*cursor >= '1' && *cursor <= '9')) {
+            if (*cursor == '*') {
+                fits = fits && appendWord(record, &length, (uint32_t)va_arg(args, int));
+            }
+            cursor++;
+        }
+
+        char size = '\0';
+        if (*cursor == 'l' || *cursor == 'z') {
+            size = *cursor++;
+        }
+        switch (*cursor) {
+            case 'd':
+            case 'i':
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'c':
+                if (size == 'l') {
+                    fits = fits && appendWord(record, &length, (uint32_t)va_arg(args, unsigned long));
+                } else if (size == 'z') {
+                    fits = fits && appendWord(record, &length, (uint32_t)va_arg(args, size_t));
+                } else {
+                    fits = fits && appendWord(record, &length, va_arg(args, unsigned int));
+                }
+                break;
+            case 's':
+                fits = fits && appendString(record, &length, va_arg(args, const char *));
+                break;
+            case '\0':  // stray '%' at the end of the format
+                cursor--;
+                break;
+            default:
+                break;
+        }
+    }
+    va_end(args);
+
+    if (!fits || length > logRing.mask + 1 - consoleRingAvailable(&logRing)) {
+        logDropped++;
+        return;
+    }
+    consoleRingWrite(&logRing, record, length);
+}
+
+/**
+ * @brief Sends all pending log records
+ *
+ * Passes the bytes in the log ring to write in at most two contiguous blocks, straight
+ * from the ring storage, typically to a debug UART or a file. Records logged while
+ * write runs are left for the next call.
+ *
+ * @param write Function sending raw bytes, e.g. the console_io_t::write of a debug port
+ * @return Number of bytes sent
+ */
+size_t consoleLogDrain(void (*write)(const void *data, size_t len)) {
+    return consoleRingDrain(&logRing, write);
+}
+
+/**
+ * @brief Returns the number of records dropped because the log ring was full or the
+ *        format string lies beyond the 16-bit ID range
+ */
+uint32_t consoleLogDropped(void) {
+    return logDropped;
+}
+
+#pragma endregion External Functions
+
+#pragma region Private Functions
+
+static bool appendWord(uint8_t *record, size_t *length, uint32_t value) {
+    if (*length + 4 > CONSOLE_LOG_RECORD_SIZE) {
+        return false;
+    }
+    for (int byte = 0; byte < 4; byte++) {
+        record[(*length)++] = (uint8_t)(value >> (8 * byte));
+    }
+    return true;
+}
+
+/**
+ * @brief Appends a string with its terminating NUL, truncated to the space left.
+ *
+ * @return false if not even the terminating NUL fits
+ */
+static bool appendString(uint8_t *record, size_t *length, const char *string) {
+    if (*length >= CONSOLE_LOG_RECORD_SIZE) {
+        return false;
+    }
+    if (string == NULL) {
+        string = "(null)";
+    }
+    while (*string && *length < CONSOLE_LOG_RECORD_SIZE - 1) {
+        record[(*length)++] = (uint8_t)*string++;
+    }
+    record[(*length)++] = '\0';
+    return true;
+}
+
+#pragma endregion Private Functions
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,81 @@
+/**
+ * @file console_log.h
+ * @brief Deferred binary logging with format strings replaced by IDs
+ * @version 1.0
+ * @date 2024-11-13
+ */
+
+#ifndef CONSOLE_LOG_H
+#define CONSOLE_LOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma region includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma endregion includes
+
+#pragma region defines
+
+#if !defined(__GNUC__) || !defined(__ELF__)
+#error "console_log requires GCC or Clang on an ELF target"
+#endif
+
+/**
+ * @brief Maximum size of one encoded log record, including the format ID.
+ *
+ * Records that do not fit are dropped and counted by consoleLogDropped().
+ */
+#ifndef CONSOLE_LOG_RECORD_SIZE
+#define CONSOLE_LOG_RECORD_SIZE 64
+#endif
+
+/**
+ * @brief Logs a message without formatting it on the target
+ *
+ * Takes a printf-style format string literal and its arguments. The format string is
+ * placed into the "console_log" section and identified by its offset in that section;
+ * only this 16-bit ID and the raw argument values are appended to the log ring, where
+ * they wait for consoleLogDrain(). The section therefore must not exceed 64 KiB;
+ * records of format strings beyond that are dropped. tools/console_log_decode.py turns the records back
+ * into text, reading the format strings from the firmware image.
+ *
+ * Supported conversions are those of consolePrintf(): %d %i %u %x %X and %c are
+ * stored as 32-bit values, %s as the string contents, and a '*' width or precision as
+ * one more 32-bit value.
+ *
+ * Example:
+ * @code
+ * CONSOLE_LOG_DEFERRED("adc %u: %d mV\r\n", channel, millivolts);
+ * @endcode
+ */
+#define CONSOLE_LOG_DEFERRED(...) CONSOLE_LOG_DEFERRED_(__VA_ARGS__, 0)
+
+// The trailing 0 gives the argument list at least one entry; it is never read
+#define CONSOLE_LOG_DEFERRED_(format, ...)                                                                             \
+    do {                                                                                                               \
+        static const char consoleLogFormat[] __attribute__((section("console_log"))) = format;                         \
+        consoleLogWrite(consoleLogFormat, __VA_ARGS__);                                                                \
+    } while (0)
+
+#pragma endregion defines
+
+#pragma region Exported Functions
+
+bool consoleLogInit(void *storage, uint32_t size);
+void consoleLogWrite(const char *format, ...);
+size_t consoleLogDrain(void (*write)(const void *data, size_t len));
+uint32_t consoleLogDropped(void);
+
+#pragma endregion Exported Functions
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CONSOLE_LOG_H
@@ -0,0 +1,224 @@
+/**
+ * @file console_ring.c
+ * @brief Lock-free single-producer/single-consumer byte ring buffer
+ * @version 1.0
+ * @date 2024-11-13
+ */
+
+#include "console_ring.h"
+
+#include "console.h"  // CONSOLE_NO_DATA
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma region includes
+#include <string.h>
+#pragma endregion includes
+
+#pragma region defines
+
+#if defined(__GNUC__)
+#define RING_LOAD_RELAXED(ptr)       __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define RING_LOAD_ACQUIRE(ptr)       __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define RING_STORE_RELEASE(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#else
+#include <stdatomic.h>
+#define RING_LOAD_RELAXED(ptr)       (*(ptr))
+#define RING_LOAD_ACQUIRE(ptr)       ringLoadAcquire(ptr)
+#define RING_STORE_RELEASE(ptr, val) ringStoreRelease((ptr), (val))
+#endif
+
+#pragma endregion defines
+
+#pragma region Private Function Prototypes
+
+#if !defined(__GNUC__)
+static uint32_t ringLoadAcquire(const volatile uint32_t *ptr);
+static void ringStoreRelease(volatile uint32_t *ptr, uint32_t val);
+#endif
+
+#pragma endregion Private Function Prototypes
+
+#pragma region External Functions
+
+/**
+ * @brief Initializes a ring buffer over caller-provided storage
+ *
+ * @param ring Ring buffer to initialize
+ * @param storage Storage of at least size bytes, owned by the caller
+ * @param size Capacity in bytes, a power of two
+ * @return true on success, false if size is not a power of two
+ */
+bool consoleRingInit(console_ring_t *ring, void *storage, uint32_t size) {
+    if (size == 0 || (size & (size - 1)) != 0 || size > 0x80000000u) {
+        return false;
+    }
+    ring->buffer = (uint8_t *)storage;
+    ring->mask   = size - 1;
+    ring->head   = 0;
+    ring->tail   = 0;
+    return true;
+}
+
+/**
+ * @brief Appends one byte (producer side)
+ *
+ * Safe to call from an interrupt handler while the consumer runs in the main loop.
+ *
+ * @param ring Ring buffer
+ * @param byte Byte to append
+ * @return true if the byte was stored, false if the ring is full
+ */
+bool consoleRingPut(console_ring_t *ring, uint8_t byte) {
+    uint32_t head = RING_LOAD_RELAXED(&ring->head);
+    uint32_t tail = RING_LOAD_ACQUIRE(&ring->tail);
+
+    if (head - tail > ring->mask) {
+        return false;
+    }
+    ring->buffer[head & ring->mask] = byte;
+    RING_STORE_RELEASE(&ring->head, head + 1);
+    return true;
+}
+
+/**
+ * @brief Appends a block of bytes (producer side)
+ *
+ * Copies as many bytes as fit with at most two memcpy calls and publishes them with
+ * a single head update.
+ *
+ * @param ring Ring buffer
+ * @param data Bytes to append
+ * @param len Number of bytes
+ * @return Number of bytes stored, less than len if the ring filled up
+ */
+size_t consoleRingWrite(console_ring_t *ring, const void *data, size_t len) {
+    uint32_t head  = RING_LOAD_RELAXED(&ring->head);
+    uint32_t tail  = RING_LOAD_ACQUIRE(&ring->tail);
+    uint32_t space = ring->mask + 1 - (head - tail);
+    uint32_t start = head & ring->mask;
+
+    if (len > space) {
+        len = space;
+    }
+    size_t first = ring->mask + 1 - start;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(ring->buffer + start, data, first);
+    memcpy(ring->buffer, (const uint8_t *)data + first, len - first);
+    RING_STORE_RELEASE(&ring->head, head + (uint32_t)len);
+    return len;
+}
+
+/**
+ * @brief Removes one byte (consumer side)
+ *
+ * Matches the console_io_t::getchar contract, so it can back a non-blocking getchar.
+ *
+ * @param ring Ring buffer
+ * @return The byte, or CONSOLE_NO_DATA if the ring is empty
+ */
+int consoleRingGet(console_ring_t *ring) {
+    uint32_t tail = RING_LOAD_RELAXED(&ring->tail);
+    uint32_t head = RING_LOAD_ACQUIRE(&ring->head);
+
+    if (head == tail) {
+        return CONSOLE_NO_DATA;
+    }
+    uint8_t byte = ring->buffer[tail & ring->mask];
+    RING_STORE_RELEASE(&ring->tail, tail + 1);
+    return byte;
+}
+
+/**
+ * @brief Returns the number of bytes ready to be read (consumer side)
+ */
+size_t consoleRingAvailable(const console_ring_t *ring) {
+    return RING_LOAD_ACQUIRE(&ring->head) - RING_LOAD_RELAXED(&ring->tail);
+}
+
+/**
+ * @brief Returns the longest contiguous run of readable bytes without removing them (consumer side)
+ *
+ * @param ring Ring buffer
+ * @param data Receives a pointer to the first readable byte
+ * @return Number of bytes readable at *data, 0 if the ring is empty
+ */
+size_t consoleRingPeek(const console_ring_t *ring, const uint8_t **data) {
+    uint32_t tail  = RING_LOAD_RELAXED(&ring->tail);
+    uint32_t head  = RING_LOAD_ACQUIRE(&ring->head);
+    uint32_t start = tail & ring->mask;
+    size_t len     = head - tail;
+
+    if (len > ring->mask + 1 - start) {
+        len = ring->mask + 1 - start;
+    }
+    *data = ring->buffer + start;
+    return len;
+}
+
+/**
+ * @brief Removes bytes previously returned by consoleRingPeek() (consumer side)
+ *
+ * @param ring Ring buffer
+ * @param len Number of bytes to remove, at most the value returned by consoleRingPeek()
+ */
+void consoleRingSkip(console_ring_t *ring, size_t len) {
+    RING_STORE_RELEASE(&ring->tail, RING_LOAD_RELAXED(&ring->tail) + (uint32_t)len);
+}
+
+/**
+ * @brief Hands all bytes currently in the ring to a sink (consumer side)
+ *
+ * Passes the pending bytes in at most two contiguous blocks, straight from the ring
+ * storage; with consoleFeed() as the sink they go directly to the console. Bytes that
+ * arrive while the sink processes them are left for the next call, so a continuous
+ * stream cannot keep the caller in here forever.
+ *
+ * @param ring Ring buffer filled by the producer
+ * @param sink Function receiving the bytes, e.g. consoleFeed
+ * @return Number of bytes processed
+ */
+size_t consoleRingDrain(console_ring_t *ring, void (*sink)(const void *data, size_t len)) {
+    size_t remaining = consoleRingAvailable(ring);
+    size_t total     = 0;
+    const uint8_t *data;
+
+    while (remaining > 0) {
+        size_t len = consoleRingPeek(ring, &data);
+        if (len > remaining) {
+            len = remaining;
+        }
+        sink(data, len);
+        consoleRingSkip(ring, len);
+        remaining -= len;
+        total += len;
+    }
+    return total;
+}
+
+#pragma endregion External Functions
+
+#pragma region Private Functions
+
+#if !defined(__GNUC__)
+static uint32_t ringLoadAcquire(const volatile uint32_t *ptr) {
+    uint32_t val = *ptr;
+    atomic_thread_fence(memory_order_acquire);
+    return val;
+}
+
+static void ringStoreRelease(volatile uint32_t *ptr, uint32_t val) {
+    atomic_thread_fence(memory_order_release);
+    *ptr = val;
+}
+#endif
+
+#pragma endregion Private Functions
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,87 @@
+/**
+ * @file console_ring.h
+ * @brief Lock-free single-producer/single-consumer byte ring buffer
+ * @version 1.0
+ * @date 2024-11-13
+ */
+
+#ifndef CONSOLE_RING_H
+#define CONSOLE_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma region includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma endregion includes
+
+#pragma region typedef
+
+/**
+ * @brief Single-producer/single-consumer byte ring buffer
+ *
+ * @details Moves bytes from one producer (typically a UART receive ISR or a reader
+ * thread) to one consumer (the main loop) without locks or disabled interrupts. The
+ * capacity is a power of two so that positions wrap with a mask instead of a modulo,
+ * and head and tail are free-running counters: the producer only writes head, the
+ * consumer only writes tail, and each publishes its update with release semantics.
+ *
+ * Example usage:
+ * @code
+ * static uint8_t rxStorage[256];
+ * static console_ring_t rxRing;
+ *
+ * void uartRxIsr(void) {
+ *     consoleRingPut(&rxRing, UART->DR);
+ * }
+ *
+ * int main(void) {
+ *     consoleRingInit(&rxRing, rxStorage, sizeof(rxStorage));
+ *     consoleInit(&io, commands);
+ *     while (1) {
+ *         consoleRingDrain(&rxRing, consoleFeed);
+ *     }
+ * }
+ * @endcode
+ *
+ * @field buffer Storage of the ring
+ * @field mask Capacity minus one
+ * @field head Count of bytes ever written, updated by the producer
+ * @field tail Count of bytes ever read, updated by the consumer
+ */
+typedef struct {
+    uint8_t *buffer;
+    uint32_t mask;
+    volatile uint32_t head;
+    volatile uint32_t tail;
+} console_ring_t;
+
+#pragma endregion typedef
+
+#pragma region Exported Functions
+
+bool consoleRingInit(console_ring_t *ring, void *storage, uint32_t size);
+
+// Producer side
+bool consoleRingPut(console_ring_t *ring, uint8_t byte);
+size_t consoleRingWrite(console_ring_t *ring, const void *data, size_t len);
+
+// Consumer side
+int consoleRingGet(console_ring_t *ring);
+size_t consoleRingAvailable(const console_ring_t *ring);
+size_t consoleRingPeek(const console_ring_t *ring, const uint8_t **data);
+void consoleRingSkip(console_ring_t *ring, size_t len);
+size_t consoleRingDrain(console_ring_t *ring, void (*sink)(const void *data, size_t len));
+
+#pragma endregion Exported Functions
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CONSOLE_RING_H
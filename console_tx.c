@@ -0,0 +1,143 @@
+/**
+ * @file console_tx.c
+ * @brief Asynchronous transmit queue for DMA or interrupt driven console output
+ * @version 1.0
+ * @date 2024-11-13
+ */
+
+#include "console_tx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma region defines
+
+#if defined(__GNUC__)
+#define TX_CLAIM(ptr)   __atomic_exchange_n((ptr), 1u, __ATOMIC_ACQUIRE)
+#define TX_RELEASE(ptr) __atomic_store_n((ptr), 0u, __ATOMIC_RELEASE)
+#else
+#include <stdatomic.h>
+#define TX_CLAIM(ptr)   atomic_exchange_explicit((volatile _Atomic uint32_t *)(ptr), 1u, memory_order_acquire)
+#define TX_RELEASE(ptr) atomic_store_explicit((volatile _Atomic uint32_t *)(ptr), 0u, memory_order_release)
+#endif
+
+#pragma endregion defines
+
+#pragma region Private Function Prototypes
+
+static void startNextTransfer(console_tx_t *tx);
+
+#pragma endregion Private Function Prototypes
+
+#pragma region External Functions
+
+/**
+ * @brief Initializes a transmit queue over caller-provided storage
+ *
+ * @param tx Transmit queue to initialize
+ * @param storage Storage of at least size bytes, owned by the caller
+ * @param size Capacity in bytes, a power of two
+ * @param start Platform function that starts transmitting a contiguous block
+ * @return true on success, false if size is not a power of two
+ */
+bool consoleTxInit(console_tx_t *tx, void *storage, uint32_t size, void (*start)(const uint8_t *data, size_t len)) {
+    tx->start    = start;
+    tx->inFlight = 0;
+    tx->busy     = 0;
+    return consoleRingInit(&tx->ring, storage, size);
+}
+
+/**
+ * @brief Queues bytes for transmission and starts the transmitter if it is idle
+ *
+ * Returns as soon as the bytes are queued, without waiting for them to be sent. The
+ * signature matches console_io_t::write apart from the queue argument, so a one-line
+ * wrapper connects the console to the queue. What happens when the queue is full is
+ * selected at build time by CONSOLE_TX_POLICY.
+ *
+ * @param tx Transmit queue
+ * @param data Bytes to send
+ * @param len Number of bytes
+ * @return Number of bytes queued, less than len if output was discarded
+ */
+size_t consoleTxWrite(console_tx_t *tx, const void *data, size_t len) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    size_t queued        = 0;
+
+#if CONSOLE_TX_POLICY == CONSOLE_TX_DROP
+    if (len > tx->ring.mask + 1 - consoleTxPending(tx)) {
+        return 0;
+    }
+#endif
+    for (;;) {
+        queued += consoleRingWrite(&tx->ring, bytes + queued, len - queued);
+        startNextTransfer(tx);
+#if CONSOLE_TX_POLICY == CONSOLE_TX_BLOCK
+        if (queued < len) {
+            continue;  // The completion interrupt frees space
+        }
+#endif
+        return queued;
+    }
+}
+
+/**
+ * @brief Returns the number of bytes queued or being transmitted
+ *
+ * Lets the caller wait for the output to drain, e.g. before entering a low-power mode
+ * or resetting.
+ */
+size_t consoleTxPending(const console_tx_t *tx) {
+    return consoleRingAvailable(&tx->ring);
+}
+
+/**
+ * @brief Completes the running transfer and starts the next one
+ *
+ * Must be called by the platform, typically from the DMA or UART interrupt handler,
+ * when the block passed to start has been sent.
+ *
+ * @param tx Transmit queue
+ */
+void consoleTxComplete(console_tx_t *tx) {
+    consoleRingSkip(&tx->ring, tx->inFlight);
+    tx->inFlight = 0;
+    TX_RELEASE(&tx->busy);
+    startNextTransfer(tx);
+}
+
+#pragma endregion External Functions
+
+#pragma region Private Functions
+
+/**
+ * @brief Starts a transfer of the oldest queued bytes unless one is running.
+ *
+ * Both the writer and the completion interrupt call this; the busy flag is claimed
+ * atomically, so exactly one of them starts the transfer and bytes queued while the
+ * previous transfer completed are never left behind.
+ */
+static void startNextTransfer(console_tx_t *tx) {
+    const uint8_t *data = NULL;
+    size_t len          = 0;
+
+    while (consoleRingAvailable(&tx->ring) > 0) {
+        if (TX_CLAIM(&tx->busy) != 0) {
+            return;  // A transfer is running; its completion starts the next one
+        }
+        len = consoleRingPeek(&tx->ring, &data);
+        if (len > 0) {
+            tx->inFlight = len;
+            tx->start(data, len);
+            return;
+        }
+        TX_RELEASE(&tx->busy);
+    }
+}
+
+#pragma endregion Private Functions
+
+#ifdef __cplusplus
+}
+#endif
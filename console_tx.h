@@ -0,0 +1,105 @@
+/**
+ * @file console_tx.h
+ * @brief Asynchronous transmit queue for DMA or interrupt driven console output
+ * @version 1.0
+ * @date 2024-11-13
+ */
+
+#ifndef CONSOLE_TX_H
+#define CONSOLE_TX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma region includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "console_ring.h"
+
+#pragma endregion includes
+
+#pragma region defines
+
+#define CONSOLE_TX_BLOCK    0 /**< Wait for the transmitter to make room */
+#define CONSOLE_TX_DROP     1 /**< Discard a write that does not fit completely */
+#define CONSOLE_TX_TRUNCATE 2 /**< Queue the part of a write that fits, discard the rest */
+
+/**
+ * @brief What consoleTxWrite() does when the queue is full.
+ *
+ * CONSOLE_TX_BLOCK never loses output but must not be used from an interrupt handler
+ * or with the transmit interrupt disabled. CONSOLE_TX_DROP and CONSOLE_TX_TRUNCATE
+ * never wait, which keeps the main loop deterministic at the cost of lost output.
+ */
+#ifndef CONSOLE_TX_POLICY
+#define CONSOLE_TX_POLICY CONSOLE_TX_BLOCK
+#endif
+
+#pragma endregion defines
+
+#pragma region typedef
+
+/**
+ * @brief Asynchronous transmit queue
+ *
+ * @details Output is copied once into a console_ring_t, and the platform transmits it
+ * straight out of the ring storage: start is handed the longest contiguous run of
+ * queued bytes, typically to set up a DMA transfer or enable the TX-empty interrupt,
+ * and the platform calls consoleTxComplete() from its completion interrupt when the
+ * run has been sent. The next run is then started from the interrupt, so transmission
+ * overlaps with whatever the main loop does after queuing its output.
+ *
+ * Example usage:
+ * @code
+ * static uint8_t txStorage[512];
+ * static console_tx_t tx;
+ *
+ * static void uartStart(const uint8_t *data, size_t len) {
+ *     HAL_UART_Transmit_DMA(&huart1, (uint8_t *)data, len);
+ * }
+ *
+ * void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+ *     consoleTxComplete(&tx);
+ * }
+ *
+ * static void uartWrite(const void *data, size_t len) {
+ *     consoleTxWrite(&tx, data, len);
+ * }
+ *
+ * consoleTxInit(&tx, txStorage, sizeof(txStorage), uartStart);
+ * @endcode
+ *
+ * @field ring Queued bytes; the producer is the main loop, the consumer the transmitter
+ * @field start Platform function that starts transmitting a contiguous block
+ * @field inFlight Number of bytes handed to start and not yet completed
+ * @field busy Nonzero while a transfer is in progress
+ */
+typedef struct {
+    console_ring_t ring;
+    void (*start)(const uint8_t *data, size_t len);
+    volatile size_t inFlight;
+    volatile uint32_t busy;
+} console_tx_t;
+
+#pragma endregion typedef
+
+#pragma region Exported Functions
+
+bool consoleTxInit(console_tx_t *tx, void *storage, uint32_t size, void (*start)(const uint8_t *data, size_t len));
+size_t consoleTxWrite(console_tx_t *tx, const void *data, size_t len);
+size_t consoleTxPending(const console_tx_t *tx);
+
+// Called by the platform from its transmit completion interrupt
+void consoleTxComplete(console_tx_t *tx);
+
+#pragma endregion Exported Functions
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CONSOLE_TX_H
@@ -0,0 +1,115 @@
+/**
+ * @file console_bench_ring.c
+ * @brief Host throughput benchmark of the SPSC ring buffer
+ * @version 1.0
+ * @date 2024-11-13
+ *
+ * A producer thread pushes a counting byte sequence into a console_ring_t, byte by
+ * byte with consoleRingPut() as a receive ISR would, or in blocks with
+ * consoleRingWrite(). The main thread drains it with consoleRingDrain() and checks
+ * every byte, so lost, duplicated or reordered bytes are reported as errors. Either
+ * side yields the CPU when the ring is full or empty, so the benchmark also completes
+ * on a single core.
+ *
+ * Build and run on the host:
+ * @code
+ * cc -O2 -pthread -I. -o console_bench_ring tools/console_bench_ring.c console_ring.c && ./console_bench_ring
+ * @endcode
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "console_ring.h"
+
+#define BENCH_BYTES      (64u * 1024u * 1024u)
+#define BENCH_RING_SIZE  1024u
+#define BENCH_BLOCK_SIZE 64u
+
+static uint8_t benchStorage[BENCH_RING_SIZE];
+static console_ring_t benchRing;
+static size_t benchReceived;
+static size_t benchErrors;
+
+static void *producePerByte(void *arg) {
+    uint8_t value = 0;
+
+    (void)arg;
+    for (uint32_t sent = 0; sent < BENCH_BYTES;) {
+        if (consoleRingPut(&benchRing, value)) {
+            value++;
+            sent++;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *produceBlocks(void *arg) {
+    uint8_t sequence[256];
+    size_t offset = 0;
+
+    (void)arg;
+    for (uint32_t idx = 0; idx < sizeof(sequence); idx++) {
+        sequence[idx] = (uint8_t)idx;
+    }
+    // BENCH_BLOCK_SIZE divides 256, so a block never wraps around the sequence
+    for (uint32_t sent = 0; sent < BENCH_BYTES;) {
+        size_t len = consoleRingWrite(&benchRing, sequence + offset, BENCH_BLOCK_SIZE - offset % BENCH_BLOCK_SIZE);
+
+        if (len == 0) {
+            sched_yield();
+        }
+        sent += (uint32_t)len;
+        offset = (offset + len) % sizeof(sequence);
+    }
+    return NULL;
+}
+
+static void checkBytes(const void *data, size_t len) {
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    for (size_t idx = 0; idx < len; idx++) {
+        if (bytes[idx] != (uint8_t)(benchReceived + idx)) {
+            benchErrors++;
+        }
+    }
+    benchReceived += len;
+}
+
+static double benchSeconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static void benchRun(const char *name, void *(*producer)(void *arg)) {
+    pthread_t thread;
+    double start = 0;
+
+    consoleRingInit(&benchRing, benchStorage, sizeof(benchStorage));
+    benchReceived = 0;
+    benchErrors   = 0;
+
+    start = benchSeconds();
+    pthread_create(&thread, NULL, producer, NULL);
+    while (benchReceived < BENCH_BYTES) {
+        if (consoleRingDrain(&benchRing, checkBytes) == 0) {
+            sched_yield();
+        }
+    }
+    pthread_join(thread, NULL);
+
+    printf("%-10s %8.1f MB/s, %zu errors\n", name, (double)BENCH_BYTES / (benchSeconds() - start) / 1e6, benchErrors);
+}
+
+int main(void) {
+    benchRun("per byte", producePerByte);
+    benchRun("blocks", produceBlocks);
+    return 0;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file console_bench_tokenize.c
+ * @brief Host benchmark of the command line tokenizer
+ * @version 1.0
+ * @date 2024-11-13
+ *
+ * Measures bytes per cycle for tokenizing long scripted command lines, comparing the
+ * single-pass parseToArgv() with the former four-pass sequence (shift out leading
+ * whitespace, strlen() and trim trailing whitespace, tokenize, scan again for the
+ * first delimiter). The console is compiled into the benchmark to reach its private
+ * functions.
+ *
+ * Build and run on the host:
+ * @code
+ * cc -O2 -o console_bench_tokenize tools/console_bench_tokenize.c && ./console_bench_tokenize
+ * @endcode
+ *
+ * On x86 the time stamp counter is read; elsewhere the result is in bytes per
+ * nanosecond instead.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define CONSOLE_LOG_LEVEL 0  // CONSOLE_LOG_LEVEL_NONE: keep trace output out of the loop
+
+#include "../console.c"
+
+#include <ctype.h>
+#include <stdio.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_NOW() __rdtsc()
+#define BENCH_UNIT  "cycle"
+#else
+#include <time.h>
+#define BENCH_NOW() benchNanoseconds()
+#define BENCH_UNIT  "ns"
+
+static uint64_t benchNanoseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+#endif
+
+#define BENCH_ITERATIONS 200000
+
+static const char *const benchLines[] = {
+    "    flash write 0x08004000 0123456789abcdef0123456789abcdef --verify --retries 3   \t  ",
+    "\tnet config --address 192.168.100.200 --mask 255.255.255.0 --gateway 192.168.100.1",
+    "set  motor.left.speed_limit   1500    motor.right.speed_limit   1500   ramp   250    ",
+    "log \"sensor calibration finished with offset 12 and gain 0.9981\" --level info --tag cal",
+};
+
+static char benchBuffer[CONSOLE_BUFFER_SIZE];
+static char *benchArgv[CONSOLE_MAX_ARGS + 1];
+static volatile int benchSink;
+
+static void legacyStripLeading(char *cmd) {
+    unsigned int idx  = 0;
+    unsigned int copy = 0;
+
+    while (cmd[idx] != '\0' && isspace((unsigned char)cmd[idx])) {
+        idx++;
+    }
+    if (idx > 0) {
+        while (cmd[idx] != '\0') {
+            cmd[copy++] = cmd[idx++];
+        }
+        cmd[copy] = '\0';
+    }
+}
+
+static void legacyStripTrailing(char *cmd) {
+    size_t idx = strlen(cmd);
+
+    while (idx > 0 && isspace((unsigned char)cmd[idx - 1])) {
+        cmd[--idx] = '\0';
+    }
+}
+
+static int legacyTokenize(char *cmd) {
+    int argc = 0;
+
+    legacyStripLeading(cmd);
+    legacyStripTrailing(cmd);
+    argc = parseToArgv(cmd, benchArgv, CONSOLE_MAX_ARGS);
+    for (unsigned int idx = 0; cmd[idx] != '\0'; idx++) {
+        if (isArgumentDelimiter(cmd[idx])) {
+            cmd[idx] = '\0';
+            break;
+        }
+    }
+    return argc;
+}
+
+static int singlePassTokenize(char *cmd) {
+    return parseToArgv(cmd, benchArgv, CONSOLE_MAX_ARGS);
+}
+
+static int copyOnly(char *cmd) {
+    return cmd[0];
+}
+
+/**
+ * @brief Runs one tokenizer over all benchmark lines and returns the elapsed ticks.
+ *
+ * Every line is copied into the buffer first, as the tokenizers modify it.
+ */
+static uint64_t benchRun(int (*tokenize)(char *cmd), size_t *bytes) {
+    uint64_t start = 0;
+    size_t total   = 0;
+
+    start = BENCH_NOW();
+    for (unsigned int iteration = 0; iteration < BENCH_ITERATIONS; iteration++) {
+        for (size_t line = 0; line < sizeof(benchLines) / sizeof(benchLines[0]); line++) {
+            size_t length = strlen(benchLines[line]);
+
+            memcpy(benchBuffer, benchLines[line], length + 1);
+            benchSink = tokenize(benchBuffer);
+            total += length;
+        }
+    }
+    *bytes = total;
+    return BENCH_NOW() - start;
+}
+
+int main(void) {
+    size_t bytes      = 0;
+    uint64_t baseline = benchRun(copyOnly, &bytes);
+    uint64_t legacy   = benchRun(legacyTokenize, &bytes) - baseline;
+    uint64_t single   = benchRun(singlePassTokenize, &bytes) - baseline;
+
+    printf("%zu bytes per run, line copy subtracted\n", bytes);
+    printf("four passes: %6.3f bytes/%s\n", (double)bytes / (double)legacy, BENCH_UNIT);
+    printf("single pass: %6.3f bytes/%s\n", (double)bytes / (double)single, BENCH_UNIT);
+    return 0;
+}
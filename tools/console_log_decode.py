@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""Decodes the deferred log records written by console_log.c.
+
+The format strings are read from the "console_log" section of the firmware image,
+either from the ELF file itself or from a raw dump of the section, e.g.
+
+    objcopy -O binary --only-section=console_log firmware.elf console_log.bin
+
+Usage:
+    console_log_decode.py firmware.elf [capture.bin]
+
+The binary log is read from the capture file, or from standard input if none is given,
+and the decoded messages are written to standard output.
+"""
+
+import re
+import struct
+import sys
+
+MAX_SECTION_SIZE = 0x10000  # record IDs are 16-bit offsets into the section
+
+CONVERSION = re.compile(r"%([-0]*)(\*|\d+)?(?:\.(\*|\d*))?([lz]?)([diuxXcs%])")
+
+
+def read_elf_section(image, name):
+    """Returns the contents of a section of a little-endian ELF32 or ELF64 image."""
+    is64 = image[4] == 2
+    if is64:
+        shoff, = struct.unpack_from("<Q", image, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", image, 0x3A)
+    else:
+        shoff, = struct.unpack_from("<I", image, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", image, 0x2E)
+
+    def header(index):
+        base = shoff + index * shentsize
+        if is64:
+            name_offset, = struct.unpack_from("<I", image, base)
+            offset, size = struct.unpack_from("<QQ", image, base + 0x18)
+        else:
+            name_offset, = struct.unpack_from("<I", image, base)
+            offset, size = struct.unpack_from("<II", image, base + 0x10)
+        return name_offset, offset, size
+
+    _, names_offset, _ = header(shstrndx)
+    for index in range(shnum):
+        name_offset, offset, size = header(index)
+        end = image.index(b"\0", names_offset + name_offset)
+        if image[names_offset + name_offset:end].decode() == name:
+            return image[offset:offset + size]
+    raise SystemExit(f"section {name} not found")
+
+
+def load_formats(path):
+    with open(path, "rb") as file:
+        image = file.read()
+    if image[:4] == b"\x7fELF":
+        return read_elf_section(image, "console_log")
+    return image
+
+
+class Stream:
+    def __init__(self, data):
+        self.data = data
+        self.position = 0
+
+    def take(self, count):
+        if self.position + count > len(self.data):
+            raise EOFError
+        chunk = self.data[self.position:self.position + count]
+        self.position += count
+        return chunk
+
+    def word(self):
+        return struct.unpack("<I", self.take(4))[0]
+
+    def string(self):
+        end = self.data.find(b"\0", self.position)
+        if end < 0:
+            raise EOFError
+        text = self.data[self.position:end].decode(errors="replace")
+        self.position = end + 1
+        return text
+
+
+def signed(value):
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def decode_record(formats, stream):
+    format_id, = struct.unpack("<H", stream.take(2))
+    end = formats.index(b"\0", format_id)
+    format_string = formats[format_id:end].decode()
+
+    def convert(match):
+        flags, width, precision, _, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+        if width == "*":
+            width = str(signed(stream.word()))
+        if precision == "*":
+            precision = str(signed(stream.word()))
+        spec = "%" + flags + (width or "") + ("." + precision if precision is not None else "")
+        if conversion == "s":
+            return (spec + "s") % stream.string()
+        value = stream.word()
+        if conversion == "c":
+            return (spec + "c") % chr(value & 0xFF)
+        if conversion in "di":
+            return (spec + "d") % signed(value)
+        return (spec + conversion) % value
+
+    return CONVERSION.sub(convert, format_string)
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        raise SystemExit(__doc__)
+    formats = load_formats(sys.argv[1])
+    if len(formats) > MAX_SECTION_SIZE:
+        raise SystemExit(f"console_log section is {len(formats)} bytes, but 16-bit record IDs "
+                         f"only address the first {MAX_SECTION_SIZE}")
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], "rb") as file:
+            data = file.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    stream = Stream(data)
+    try:
+        while stream.position < len(data):
+            sys.stdout.write(decode_record(formats, stream))
+    except EOFError:
+        sys.stderr.write("truncated record at end of log\n")
+
+
+if __name__ == "__main__":
+    main()